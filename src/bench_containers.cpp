@@ -0,0 +1,406 @@
+#include <bits/stdc++.h>
+#include <util/parallel.hpp>
+#include <util/histogram_heap.hpp>
+#include <util/histogram_sort.hpp>
+#include <graph/static.hpp>
+using namespace std;
+
+using namespace graph;
+using namespace util;
+
+//  Microbenchmarks of the containers under the algorithms, on synthetic workloads shaped like
+//  their use by the solvers, each compared with a baseline from the standard library.
+//  usage: bench_containers [-n Size] [-d AverageDegree] [-r Seed] [-f Filter] [-m MinTime] [-t Threads] [-j] [-b BaselinePath] [-x MaxSlowdown]
+//  Prints one row Benchmark,Iterations,Items,MeanNs,MinNs,NsPerItem per benchmark, or JSON with -j.
+//  With -b, compares NsPerItem with that of a CSV written before and fails if any benchmark got
+//  slower by more than MaxSlowdown.
+
+typedef static_graph<int, int, long long> graph_type;
+typedef graph_type::edge_type edge_type;
+
+struct benchmark {
+    string name;
+    size_t items;                   //  Operations per iteration
+    function<void()> setup;         //  Before each iteration, not timed
+    function<uint64_t()> run;       //  Returns a checksum, so that the work is not optimized away
+};
+
+struct result {
+    string name;
+    size_t iterations, items;
+    double mean_ns, min_ns;
+
+    double ns_per_item() const { return min_ns / max<size_t>(items, 1); }
+};
+
+volatile uint64_t sink;
+
+//  Runs b once to warm up, and then until min_time seconds have been timed, at least 3 times
+result measure(const benchmark& b, double min_time) {
+    result r{ b.name, 0, b.items, 0, numeric_limits<double>::max() };
+    double total = 0;
+    for (int warm = 1; warm >= 0 && (warm || total < min_time * 1e9 || r.iterations < 3); ) {
+        if (b.setup) b.setup();
+        auto t0 = chrono::steady_clock::now();
+        sink = b.run();
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+        if (warm) {
+            warm = 0;
+            continue;
+        }
+        total += ns;
+        r.min_ns = min(r.min_ns, ns);
+        ++r.iterations;
+    }
+    r.mean_ns = total / r.iterations;
+    return r;
+}
+
+//  Random keys in [0, m] and a random walk on them as Greedy makes: each pop of the top is
+//  followed by `walk` changes of at most `step` to the keys of random elements still in the
+//  heap, kept within [0, m].
+struct walk_workload {
+    long long m;
+    vector<long long> keys;
+    vector<int> targets;
+    vector<long long> steps;
+    int walk;
+
+    walk_workload(int n, long long m_, long long step, int walk_, mt19937_64& mt) : m(m_), walk(walk_) {
+        uniform_int_distribution<long long> kd(0, m);
+        uniform_int_distribution<int> vd(0, n - 1);
+        uniform_int_distribution<long long> sd(-step, step);
+        for (int i = 0; i < n; ++i)
+            keys.push_back(kd(mt));
+        for (long long i = 0; i < (long long)n * walk; ++i) {
+            targets.push_back(vd(mt));
+            steps.push_back(sd(mt));
+        }
+    }
+
+    size_t items() const { return keys.size() * (walk + 1); }
+
+    //  Runs the workload on a heap with top, pop, key and modify_key
+    template<class Heap>
+    uint64_t run(Heap& h) const {
+        const int n = keys.size();
+        vector<char> removed(n, 0);
+        uint64_t sum = 0;
+        size_t j = 0;
+        for (int k = 0; k < n; ++k) {
+            int u = h.top();
+            sum = sum * 31 + h.key(u);
+            h.pop();
+            removed[u] = 1;
+            for (int s = 0; s < walk; ++s, ++j) {
+                int v = targets[j];
+                if (removed[v]) continue;
+                h.modify_key(v, min(m, max(0ll, h.key(v) + steps[j])));
+            }
+        }
+        return sum;
+    }
+};
+
+//  The interface of the heaps on std::priority_queue, where modify_key pushes the element again
+//  and pop skips the entries that are out of date
+class lazy_priority_queue {
+    priority_queue<pair<long long, int>> q;
+    vector<long long> k;
+    vector<char> removed;
+
+    void skip() {
+        while (removed[q.top().second] || q.top().first != k[q.top().second])
+            q.pop();
+    }
+
+public:
+    lazy_priority_queue(const vector<long long>& keys) : k(keys), removed(keys.size(), 0) {
+        vector<pair<long long, int>> v;
+        for (int i = 0; i < (int)k.size(); ++i)
+            v.emplace_back(k[i], i);
+        q = priority_queue<pair<long long, int>>(less<pair<long long, int>>(), move(v));
+    }
+
+    int top() {
+        skip();
+        return q.top().second;
+    }
+
+    void pop() {
+        skip();
+        removed[q.top().second] = 1;
+        q.pop();
+    }
+
+    long long key(int i) const { return k[i]; }
+
+    void modify_key(int i, long long x) {
+        if (k[i] == x) return;
+        k[i] = x;
+        q.emplace(x, i);
+    }
+};
+
+//  Vertex with a power-law degree: x^3 for x uniform in [0, 1) puts a fraction f^(1/3) of the
+//  draws on the lowest fraction f of the labels, which are then shuffled
+struct power_law {
+    vector<int> label;
+    uniform_real_distribution<double> ud;
+
+    power_law(int n, mt19937_64& mt) : label(n) {
+        iota(label.begin(), label.end(), 0);
+        shuffle(label.begin(), label.end(), mt);
+    }
+
+    int operator()(mt19937_64& mt) {
+        double x = ud(mt);
+        return label[min<size_t>(label.size() - 1, size_t(x * x * x * label.size()))];
+    }
+};
+
+vector<edge_type> power_law_edges(int n, long long m, mt19937_64& mt) {
+    power_law src(n, mt), dst(n, mt);
+    uniform_int_distribution<long long> wd(1, 100);
+    vector<edge_type> es;
+    es.reserve(m);
+    for (long long i = 0; i < m; ++i) {
+        int u = src(mt);
+        es.emplace_back(u, dst(mt), wd(mt));
+    }
+    return es;
+}
+
+//  Baseline of the adjacency lists of static_graph: offsets and sorted (dst, weight) pairs
+struct csr {
+    vector<int> off;
+    vector<pair<int, long long>> adj;
+
+    csr(int n, const vector<edge_type>& es) : off(n + 1, 0), adj(es.size()) {
+        for (const edge_type& e : es)
+            off[e.src + 1]++;
+        partial_sum(off.begin(), off.end(), off.begin());
+        vector<int> p(off.begin(), off.end() - 1);
+        for (const edge_type& e : es)
+            adj[p[e.src]++] = { e.dst, e.weight };
+        for (int v = 0; v < n; ++v)
+            sort(adj.begin() + off[v], adj.begin() + off[v + 1]);
+    }
+};
+
+bool edge_less(const edge_type& a, const edge_type& b) {
+    return a.src != b.src ? a.src < b.src : a.dst < b.dst;
+}
+
+//  Rows of a CSV written by this program, by benchmark name
+bool read_baseline(const string& path, map<string, double>& base) {
+    ifstream ifs(path);
+    if (!ifs) return false;
+    string line;
+    getline(ifs, line);
+    while (getline(ifs, line)) {
+        vector<string> f;
+        stringstream ss(line);
+        string x;
+        while (getline(ss, x, ','))
+            f.push_back(x);
+        if (f.size() < 6) return false;
+        base[f[0]] = atof(f[5].c_str());
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int n = 1 << 18, d = 8;
+    long long seed = 0;
+    string filter, bpath;
+    double min_time = 0.5, max_slowdown = 0.1;
+    bool json = false;
+    {
+        int i = 1;
+        while (i < argc) {
+            if (argv[i] == "-j"s) {
+                json = true;
+                ++i;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Option %s must not be empty!\n", argv[i]);
+                return -1;
+            }
+            if (argv[i] == "-n"s)
+                n = max(1, atoi(argv[i + 1]));
+            else if (argv[i] == "-d"s)
+                d = max(1, atoi(argv[i + 1]));
+            else if (argv[i] == "-r"s)
+                seed = atoll(argv[i + 1]);
+            else if (argv[i] == "-f"s)
+                filter = argv[i + 1];
+            else if (argv[i] == "-m"s)
+                min_time = atof(argv[i + 1]);
+            else if (argv[i] == "-t"s)
+                set_num_threads(max(1, atoi(argv[i + 1])));
+            else if (argv[i] == "-b"s)
+                bpath = argv[i + 1];
+            else if (argv[i] == "-x"s)
+                max_slowdown = atof(argv[i + 1]);
+            else {
+                fprintf(stderr, "Error: Unrecognized option %s\n", argv[i]);
+                return -1;
+            }
+            i += 2;
+        }
+    }
+    map<string, double> base;
+    if (!bpath.empty() && !read_baseline(bpath, base)) {
+        fprintf(stderr, "Error: Can not read baseline %s\n", bpath.c_str());
+        return -1;
+    }
+
+    mt19937_64 mt(seed);
+    vector<benchmark> bs;
+
+    //  Heaps: narrow keys as in unweighted Greedy, where the histogram heap is used, and wide
+    //  keys as in weighted Greedy, where it would move elements one key at a time
+    const walk_workload narrow(n, 2 * d * 4, 2, 4, mt), wide(n, 1 << 24, 1 << 10, 4, mt);
+    for (const walk_workload* w : { &narrow, &wide }) {
+        const string prefix = w == &narrow ? "heap/walk_narrow/" : "heap/walk_wide/";
+        if (w == &narrow)
+            bs.push_back({ prefix + "histogram_heap", w->items(), nullptr, [w]() {
+                static_histogram_max_heap<long long, int> h(w->m, w->keys.begin(), w->keys.end());
+                return w->run(h);
+            } });
+        bs.push_back({ prefix + "bucket_heap", w->items(), nullptr, [w]() {
+            static_bucket_max_heap<long long, int> h(w->m, w->keys.begin(), w->keys.end());
+            return w->run(h);
+        } });
+        bs.push_back({ prefix + "priority_queue", w->items(), nullptr, [w]() {
+            lazy_priority_queue h(w->keys);
+            return w->run(h);
+        } });
+    }
+
+    //  Sorting arcs by (src, dst) with power-law sources, as merge_parallel_edges does: inputs
+    //  smaller than radix_sort_threshold take the counting sort, larger ones the radix sort
+    const auto sort_edges = make_shared<const vector<edge_type>>(power_law_edges(n, (long long)n * d, mt));
+    const auto small_edges = make_shared<const vector<edge_type>>(sort_edges->begin(),
+        sort_edges->begin() + min<size_t>(sort_edges->size(), radix_sort_threshold / 2));
+    const auto buf = make_shared<vector<edge_type>>();
+    for (auto in : { small_edges, sort_edges }) {
+        const string prefix = in == small_edges ? "sort/power_law_small/" : "sort/power_law/";
+        auto setup = [in, buf]() { buf->assign(in->begin(), in->end()); };
+        auto check = [buf]() {
+            uint64_t h = 0;
+            for (size_t i = 0; i < buf->size(); i += 1 + buf->size() / 1024)
+                h = h * 31 + (*buf)[i].src * 7 + (*buf)[i].dst;
+            return h;
+        };
+        bs.push_back({ prefix + "histogram_sort", in->size(), setup, [buf, check]() {
+            histogram_sort(buf->begin(), buf->end(), src<>(), dst<>());
+            return check();
+        } });
+        bs.push_back({ prefix + "std_sort", in->size(), setup, [buf, check]() {
+            sort(buf->begin(), buf->end(), edge_less);
+            return check();
+        } });
+        bs.push_back({ prefix + "std_stable_sort", in->size(), setup, [buf, check]() {
+            stable_sort(buf->begin(), buf->end(), edge_less);
+            return check();
+        } });
+    }
+
+    //  Adjacency lists of static_graph on histogram_map, against plain CSR arrays: scans of the
+    //  out-lists in vertex order and in random order, and lookups of arcs by source and target
+    const auto g = make_shared<const graph_type>(n, sort_edges->begin(), sort_edges->end());
+    const auto c = make_shared<const csr>(n, *sort_edges);
+    const auto order = make_shared<vector<int>>(n);
+    iota(order->begin(), order->end(), 0);
+    shuffle(order->begin(), order->end(), mt);
+    const auto queries = make_shared<vector<pair<int, int>>>();
+    {
+        uniform_int_distribution<size_t> ed(0, sort_edges->size() - 1);
+        uniform_int_distribution<int> vd(0, n - 1);
+        for (int i = 0; i < n; ++i) {
+            const edge_type& e = (*sort_edges)[ed(mt)];
+            queries->emplace_back(e.src, i % 2 ? e.dst : vd(mt));   //  Half of them hit
+        }
+    }
+    for (bool random_order : { false, true }) {
+        const string prefix = random_order ? "map/power_law_random/" : "map/power_law_scan/";
+        bs.push_back({ prefix + "histogram_map", size_t(g->num_edges()), nullptr, [g, order, random_order]() {
+            uint64_t s = 0;
+            for (int i = 0; i < g->num_vertices(); ++i)
+                for (const auto& e : g->out_edges(random_order ? (*order)[i] : i))
+                    s += e.dst ^ e.weight;
+            return s;
+        } });
+        bs.push_back({ prefix + "csr", size_t(g->num_edges()), nullptr, [c, order, random_order]() {
+            uint64_t s = 0;
+            const int nv = c->off.size() - 1;
+            for (int i = 0; i < nv; ++i) {
+                const int v = random_order ? (*order)[i] : i;
+                for (int j = c->off[v]; j < c->off[v + 1]; ++j)
+                    s += c->adj[j].first ^ c->adj[j].second;
+            }
+            return s;
+        } });
+    }
+    bs.push_back({ "map/power_law_lookup/histogram_map", queries->size(), nullptr, [g, queries]() {
+        uint64_t s = 0;
+        for (const auto& [u, v] : *queries)
+            for (const auto& e : g->out_edges(u)(v))
+                s += e.weight;
+        return s;
+    } });
+    bs.push_back({ "map/power_law_lookup/csr", queries->size(), nullptr, [c, queries]() {
+        uint64_t s = 0;
+        for (const auto& [u, v] : *queries) {
+            auto b = c->adj.begin() + c->off[u], e = c->adj.begin() + c->off[u + 1];
+            for (auto it = lower_bound(b, e, make_pair(v, LLONG_MIN)); it != e && it->first == v; ++it)
+                s += it->second;
+        }
+        return s;
+    } });
+
+    vector<result> rs;
+    const regex re(filter);
+    if (json)
+        printf("{\n  \"context\": {\"size\": %d, \"degree\": %d, \"seed\": %lld, \"threads\": %u},\n  \"benchmarks\": [", n, d, seed, num_threads());
+    else
+        printf("Benchmark,Iterations,Items,MeanNs,MinNs,NsPerItem\n");
+    for (const benchmark& b : bs) {
+        if (!filter.empty() && !regex_search(b.name, re)) continue;
+        const result r = measure(b, min_time);
+        if (json)
+            printf("%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"items\": %zu, \"mean_ns\": %.0f, \"min_ns\": %.0f, \"ns_per_item\": %.3f}",
+                rs.empty() ? "" : ",", r.name.c_str(), r.iterations, r.items, r.mean_ns, r.min_ns, r.ns_per_item());
+        else
+            printf("%s,%zu,%zu,%.0f,%.0f,%.3f\n", r.name.c_str(), r.iterations, r.items, r.mean_ns, r.min_ns, r.ns_per_item());
+        fflush(stdout);
+        rs.push_back(r);
+    }
+    if (json)
+        printf("\n  ]\n}\n");
+
+    if (bpath.empty())
+        return 0;
+    int regressions = 0;
+    for (const result& r : rs) {
+        auto it = base.find(r.name);
+        if (it == base.end()) {
+            fprintf(stderr, "%s: not in the baseline\n", r.name.c_str());
+            continue;
+        }
+        const double change = it->second > 0 ? r.ns_per_item() / it->second - 1 : 0;
+        const bool slower = change > max_slowdown;
+        regressions += slower;
+        fprintf(stderr, "%s: %.3f ns per item, %.3f in the baseline (%+.1f%%)%s\n", r.name.c_str(),
+            r.ns_per_item(), it->second, change * 100, slower ? " REGRESSION" : "");
+    }
+    if (regressions > 0) {
+        fprintf(stderr, "%d of %zu benchmarks are more than %.0f%% slower than the baseline\n",
+            regressions, rs.size(), max_slowdown * 100);
+        return 1;
+    }
+    return 0;
+}
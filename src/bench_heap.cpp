@@ -0,0 +1,130 @@
+#include <bits/stdc++.h>
+#include <graph/static.hpp>
+#include <FAS/common.hpp>
+#include <FAS/greedy.hpp>
+#include <FAS/dispatch.hpp>
+using namespace std;
+
+using namespace graph;
+using namespace util;
+using namespace FAS;
+
+typedef static_graph<int, int, long long> graph_type;
+
+//  Random graph with n vertices and n * d arcs without self-loops, of weights in [1, w]
+graph_type random_weighted_graph(int n, int d, long long w, unsigned long long seed) {
+    mt19937_64 mt(seed);
+    uniform_int_distribution<int> uid(0, n - 1);
+    uniform_int_distribution<long long> wid(1, w);
+    vector<graph_type::edge_type> es;
+    while ((long long)es.size() < (long long)n * d) {
+        int u = uid(mt), v = uid(mt);
+        if (u != v) es.emplace_back(u, v, wid(mt));
+    }
+    return graph_type(n, es.begin(), es.end());
+}
+
+//  Solve the graphs listed in path with the algorithms listed, and compare the weights of the
+//  FAS with the solutions listed. Returns the number of rows that differ.
+int check(const char* path) {
+    ifstream ifs(path);
+    if (!ifs) {
+        fprintf(stderr, "Error: Cannot open %s\n", path);
+        return -1;
+    }
+    string line;
+    getline(ifs, line);
+    int rows = 0, diffs = 0;
+    while (getline(ifs, line)) {
+        istringstream iss(line);
+        string alg;
+        int n, d;
+        long long w, expected;
+        unsigned long long seed;
+        if (!getline(iss, alg, '\t') || !(iss >> n >> d >> w >> seed >> expected)) continue;
+        graph_type g = random_weighted_graph(n, d, w, seed);
+        solution<graph_type> rk;
+        if (!solve_by_name(g, alg, solve_options<graph_type>(), rk)) return -1;
+        long long got = get_fas_weight(g, rk);
+        ++rows;
+        if (got != expected) {
+            printf("%s\t%d\t%d\t%lld\t%llu\texpected %lld, got %lld\n", alg.c_str(), n, d, w, seed, expected, got);
+            ++diffs;
+        }
+    }
+    printf("%d of %d solutions differ\n", diffs, rows);
+    return diffs;
+}
+
+//  Compares Greedy with static_histogram_max_heap and static_bucket_max_heap
+//  on a random graph for growing arc weight ranges.
+//  usage: bench_heap [-n Vertices] [-d AverageDegree] [-r Seed] [-c BaselinePath]
+//  Prints maxw,old_ms,new_ms,old_fas,new_fas, with old_ms empty where the
+//  histogram heap would need more than 2^20 buckets.
+//  With -c, instead checks that the algorithms give the solutions of BaselinePath, such as
+//  results/WeightedCheck.csv, on its random weighted graphs, and exits non-zero if any differs.
+int main(int argc, char** argv) {
+    typedef graph_type graph;
+    typedef edge_weight_t<graph> edge_weight;
+    typedef util::static_histogram_max_heap<edge_weight, int> old_heap;
+    typedef util::static_bucket_max_heap<edge_weight, int> new_heap;
+
+    int n = 1 << 18, d = 8;
+    long long seed = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (argv[i] == "-n"s)
+            n = atoi(argv[i + 1]);
+        else if (argv[i] == "-d"s)
+            d = atoi(argv[i + 1]);
+        else if (argv[i] == "-r"s)
+            seed = atoll(argv[i + 1]);
+        else if (argv[i] == "-c"s)
+            return check(argv[i + 1]) == 0 ? 0 : 1;
+        else {
+            fprintf(stderr, "Error: Unrecognized option %s\n", argv[i]);
+            return -1;
+        }
+    }
+
+    const long long W[] = { 1, 10, 100, 1000, 10000, 1000000, 1000000000 };
+    const long long max_buckets = 1 << 20;
+
+    mt19937_64 mt(seed);
+    uniform_int_distribution<int> uid(0, n - 1);
+    vector<graph::edge_type> es;
+    for (long long i = 0; i < (long long)n * d; ++i)
+        es.emplace_back(uid(mt), uid(mt), 1);
+
+    printf("maxw,old_ms,new_ms,old_fas,new_fas\n");
+    for (long long w : W) {
+        uniform_int_distribution<edge_weight> wid(1, w);
+        for (graph::edge_type& e : es)
+            e.weight = wid(mt);
+        graph g(n, es.begin(), es.end());
+
+        vector<edge_weight> iws(n), ows(n);
+        for (const auto& e : g.edges()) {
+            iws[e.dst] += e.weight;
+            ows[e.src] += e.weight;
+        }
+        edge_weight mw = max(*max_element(iws.begin(), iws.end()), *max_element(ows.begin(), ows.end()));
+
+        string old_ms, old_fas;
+        if (2 * mw + 1 <= max_buckets) {
+            auto t0 = chrono::steady_clock::now();
+            solution<graph> rk = greedy_impl<graph, true, old_heap>(g).rk;
+            auto t1 = chrono::steady_clock::now();
+            old_ms = to_string(chrono::duration_cast<chrono::milliseconds>(t1 - t0).count());
+            old_fas = to_string(get_fas_weight(g, rk));
+        }
+
+        auto t0 = chrono::steady_clock::now();
+        solution<graph> rk = greedy_impl<graph, true, new_heap>(g).rk;
+        auto t1 = chrono::steady_clock::now();
+        long long new_ms = chrono::duration_cast<chrono::milliseconds>(t1 - t0).count();
+
+        printf("%lld,%s,%lld,%s,%lld\n", w, old_ms.c_str(), new_ms, old_fas.c_str(), (long long)get_fas_weight(g, rk));
+        fflush(stdout);
+    }
+    return 0;
+}
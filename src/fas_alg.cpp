@@ -7,19 +7,25 @@
 #include <FAS/reduction.hpp>
 #include <FAS/hybrid.hpp>
 #include <FAS/HCS.hpp>
+#include <FAS/local_search.hpp>
+#include <FAS/memetic.hpp>
+#include <FAS/exact.hpp>
+#include <FAS/lower_bound.hpp>
+#include <FAS/incremental.hpp>
+#include <FAS/dispatch.hpp>
 using namespace std;
 
 using namespace graph;
 using namespace util;
 using namespace FAS;
 
-//  usage: fas_alg InputGraphPath InputGraphType Algname  [-r Seed] [-p] [-w MaxWeight] [-o OutputSolutionPath]
+//  usage: fas_alg InputGraphPath InputGraphType Algname  [-r Seed] [-p] [-w MaxWeight] [-q Ratio] [-a Slack] [-f Flatness] [-v] [-l TimeLimit] [-b Budget] [-u UpdatePath] [-d Drift] [-t Threads] [-P ProfilePath] [--perf] [-o OutputSolutionPath]
 int main(int argc, char** argv) {
     typedef static_graph<int, int, long long> graph;
     typedef vertex_id_t<graph> vertex_id;
     typedef edge_weight_t<graph> edge_weight;
     if (argc < 4) {
-        fprintf(stderr, "Not enough arguments!\n Usage: fas_alg InputGraphPath InputGraphType Algname [-r Seed] [-p] [-w MaxWeight] [-o OutputSolutionPath]");
+        fprintf(stderr, "Not enough arguments!\n Usage: fas_alg InputGraphPath InputGraphType Algname [-r Seed] [-p] [-w MaxWeight] [-q Ratio] [-a Slack] [-f Flatness] [-v] [-l TimeLimit] [-b Budget] [-u UpdatePath] [-d Drift] [-t Threads] [-P ProfilePath] [--perf] [-o OutputSolutionPath]");
         exit(-1);
     }
     string alg_name = argv[3], graph_path = argv[1], graph_type = argv[2];
@@ -33,10 +39,18 @@ int main(int argc, char** argv) {
         graph_name = graph_path;
 
     int maxw = 1;
+    double ratio = 0;
+    double slack = -1, flat = 0;
+    bool verbose = false;
+    double time_limit = 0;
+    int bound_budget = 0;
+    string upath;
+    double drift = 0.1;
     long long seed = 0;
     bool seed_provided = false;
     bool do_shuffle = false;
-    string opath;
+    string opath, ppath;
+    bool perf = false;
     {
         int i = 4;
         while (i < argc) {
@@ -54,6 +68,15 @@ int main(int argc, char** argv) {
                 do_shuffle = true;
                 ++i;
             }
+            else if (argv[i] == "-t"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Number of threads must not be empty!\n");
+                    return -1;
+                }
+                set_num_threads(atoi(argv[i]));
+                ++i;
+            }
             else if (argv[i] == "-w"s) {
                 ++i;
                 if (i >= argc) {
@@ -63,6 +86,98 @@ int main(int argc, char** argv) {
                 maxw = atoi(argv[i]);
                 ++i;
             }
+            else if (argv[i] == "-q"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Split ratio must not be empty!\n");
+                    return -1;
+                }
+                ratio = parse_ratio(argv[i]);
+                if (ratio <= 0) {
+                    fprintf(stderr, "Error: Invalid split ratio %s\n", argv[i]);
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-a"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Split slack must not be empty!\n");
+                    return -1;
+                }
+                slack = parse_slack(argv[i]);
+                if (slack < 0) {
+                    fprintf(stderr, "Error: Invalid split slack %s\n", argv[i]);
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-f"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Flatness must not be empty!\n");
+                    return -1;
+                }
+                flat = parse_flatness(argv[i]);
+                if (flat < 0) {
+                    fprintf(stderr, "Error: Invalid flatness %s, it must be between 0 and 1\n", argv[i]);
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-v"s) {
+                verbose = true;
+                ++i;
+            }
+            else if (argv[i] == "-l"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Time limit must not be empty!\n");
+                    return -1;
+                }
+                time_limit = atof(argv[i]);
+                ++i;
+            }
+            else if (argv[i] == "-b"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Budget of the lower bound must not be empty!\n");
+                    return -1;
+                }
+                bound_budget = atoi(argv[i]);
+                ++i;
+            }
+            else if (argv[i] == "-u"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Update path must not be empty!\n");
+                    return -1;
+                }
+                upath = argv[i];
+                ++i;
+            }
+            else if (argv[i] == "-d"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Drift must not be empty!\n");
+                    return -1;
+                }
+                drift = atof(argv[i]);
+                ++i;
+            }
+            else if (argv[i] == "-P"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Profile path must not be empty!\n");
+                    return -1;
+                }
+                ppath = argv[i];
+                ++i;
+            }
+            else if (argv[i] == "--perf"s) {
+                perf = true;
+                ++i;
+            }
             else if (argv[i] == "-o"s) {
                 ++i;
                 if (i >= argc) {
@@ -79,11 +194,29 @@ int main(int argc, char** argv) {
         }
     }
     vector<int> vertex_map;
+    if (!ppath.empty() || perf)
+        util::profile::enable();
+    if (perf && !util::profile::enable_hw())
+        fprintf(stderr, "Warning: Hardware counters are not available (%s), only times are reported\n", strerror(errno));
 
     graph g;
-    {
-        ifstream ifs(graph_path);
-        auto res = read_graph_impl<graph>(ifs, graph_type);
+    if (graph_type == "BIN" && !do_shuffle && maxw <= 1) {
+        //  Use the arrays of the binary file in place
+        read_stats rs;
+        if (!load_graph_bin(g, graph_path, &rs)) {
+            fprintf(stderr, "Error: Can not load binary graph %s\n", graph_path.c_str());
+            return -1;
+        }
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            graph_name.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
+        vertex_map.assign(g.num_vertices(), 0);
+        iota(vertex_map.begin(), vertex_map.end(), 0);
+    }
+    else {
+        read_stats rs;
+        auto res = read_graph_impl<graph>(graph_path, graph_type, &rs);
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            graph_name.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
         
         vertex_map.assign(res.first, 0);
         iota(vertex_map.begin(), vertex_map.end(), 0);
@@ -111,90 +244,123 @@ int main(int argc, char** argv) {
 
         g = graph(res.first, res.second.begin(), res.second.end());
     }
+    if (alg_name == "convert") {
+        if (opath.empty()) {
+            fprintf(stderr, "Error: Output path must be given with -o when converting!\n");
+            return -1;
+        }
+        if (!g.save(opath)) {
+            fprintf(stderr, "Error: Can not write binary graph %s\n", opath.c_str());
+            return -1;
+        }
+        fprintf(stderr, "Wrote %s: %d vertices and %d edges\n", opath.c_str(), g.num_vertices(), g.num_edges());
+        return 0;
+    }
+
     string task_name = graph_name + "_" + alg_name + "_" + to_string(maxw) + "_" + to_string(seed);
     // fprintf(stderr, "Task name: %s\n", task_name.c_str());
+
     // fprintf(stderr, "Read complete! %d vertices and %d edges\n", g.num_vertices(), g.num_edges());
 
     solution<graph> rk;
+    auto write_solution = [&](const string& path, const solution<graph>& s) {
+        ofstream ofs(path);
+        for (size_t i = 0; i < s.size(); ++i)
+            ofs << s[vertex_map[i]] << " \n"[i + 1 == s.size()];
+    };
     chrono::system_clock::time_point t_start = chrono::system_clock::now();
-    if (alg_name == "Greedy")
-        rk = greedy(g);
-    else if (alg_name == "scc+Greedy") {
-        coloring_result<graph> color = strongly_connected_components(g);
-        partition_result<graph> par = partition(g, color);
-        vector<solution<graph>> sv;
-        for (const auto& x : par.second)
-            sv.emplace_back(greedy(x.second));
-        rk = default_assemble(g.num_vertices(), par, sv);
-    }
-    else if (alg_name == "scc+2cyc+Greedy") {
-        fastred<graph, false, false, false> red;
-        rk = red.solve(g, greedy<graph>);
-    }
-    else if (alg_name == "scc+2cyc+chain+Greedy") {
-        fastred<graph, false, true, true> red;
-        rk = red.solve(g, greedy<graph>);
-    }
-    else if (alg_name == "RED+Greedy") {
-        fastred<graph, false> red;
-        rk = red.solve(g, greedy<graph>);
-    }
-    else if (alg_name == "REDstar+Greedy") {
-        fastred<graph, true> red;
-        rk = red.solve(g, greedy<graph>);
-    }
-    else if (alg_name == "HCS+Greedy") {
-        HCS<graph> red;
-        rk = red.solve(g, greedy<graph>);
-    }
-    else if (alg_name == "RAS2") {
-        rk = hybrid<graph, false, 2, true>(g);
-    }
-    else if (alg_name == "RAS3") {
-        rk = hybrid<graph, false, 3, true>(g);
-    }
-    else if (alg_name == "RAS4") {
-        rk = hybrid<graph, false, 4, true>(g);
-    }
-    else if (alg_name == "RAS6") {
-        rk = hybrid<graph, false, 6, true>(g);
-    }
-    else if (alg_name == "RAS8") {
-        rk = hybrid<graph, false, 8, true>(g);
-    }
-    else if (alg_name == "RAS12") {
-        rk = hybrid<graph, false, 12, true>(g);
-    }
-    else if (alg_name == "RAS16") {
-        rk = hybrid<graph, false, 16, true>(g);
-    }
-    else if (alg_name == "RAS24") {
-        rk = hybrid<graph, false, 24, true>(g);
-    }
-    else if (alg_name == "RAS32") {
-        rk = hybrid<graph, false, 32, true>(g);
-    }
-    else if (alg_name == "RAS48") {
-        rk = hybrid<graph, false, 48, true>(g);
-    }
-    else if (alg_name == "RASstar") {
-        rk = hybrid<graph, true, 3, true>(g);
-    }
-    else {
-        fprintf(stderr, "Invalid algorithm name.\n");
-        exit(-1);
+    solve_options<graph> opt;
+    opt.ratio = ratio;
+    opt.slack = slack;
+    opt.flat = flat;
+    opt.verbose = verbose;
+    opt.time_limit = time_limit;
+    opt.seed = seed;
+    //  Anytime output of Memetic: report every improvement, and keep the best ordering in the output file
+    opt.on_improve = [&](const solution<graph>& s, edge_weight w) {
+        chrono::duration<double> t = chrono::system_clock::now() - t_start;
+        fprintf(stderr, "Memetic: %lld after %.1f s\n", (long long)w, t.count());
+        if (!opath.empty()) {
+            write_solution(opath + ".tmp", s);
+            rename((opath + ".tmp").c_str(), opath.c_str());
+        }
+    };
+    {
+        util::profile::scope prof("solve");
+        if (!solve_by_name(g, alg_name, opt, rk))
+            return -1;
     }
     chrono::system_clock::time_point t_finish = chrono::system_clock::now();
 
     chrono::milliseconds time_elapsed = chrono::duration_cast<chrono::milliseconds>(t_finish-t_start);
 
-    printf("%s,%lld,%lld\n", task_name.c_str(), get_fas_weight(g, rk), time_elapsed.count());
+    printf("%s,%lld,%lld\n", task_name.c_str(), get_fas_weight(g, rk), (long long)time_elapsed.count());
+
+    if (bound_budget > 0) {
+        util::profile::scope prof("bound");
+        t_start = chrono::system_clock::now();
+        edge_weight lb = fas_lower_bound(g, cycle_packing<graph>(16, bound_budget));
+        time_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - t_start);
+        printf("%s_LB,%lld,%lld\n", task_name.c_str(), lb, (long long)time_elapsed.count());
+    }
+
+    if (!upath.empty()) {
+        ifstream ifs(upath);
+        if (!ifs) {
+            fprintf(stderr, "Error: Can not open update file %s\n", upath.c_str());
+            return -1;
+        }
+        incremental_fas<graph> inc(g, [](const graph& x) { return sifting(x, hybrid(x, true, 3, true)); }, drift, rk);
+        //  Vertices added by the updates keep their labels
+        auto label = [&](long long v) -> vertex_id { return v < (long long)vertex_map.size() ? vertex_map[v] : v; };
+        vector<graph::edge_type> ins, del;
+        int batch = 0;
+        auto flush = [&]() {
+            if (ins.empty() && del.empty()) return;
+            util::profile::scope prof("update");
+            t_start = chrono::system_clock::now();
+            inc.apply(ins, del);
+            time_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - t_start);
+            printf("%s_U%d,%lld,%lld\n", task_name.c_str(), ++batch, inc.fas_weight(), (long long)time_elapsed.count());
+            ins.clear();
+            del.clear();
+        };
+        string line;
+        for (size_t ln = 1; getline(ifs, line); ++ln) {
+            istringstream is(line);
+            char op;
+            long long u, v, w = 1;
+            if (!(is >> op)) {
+                flush();        //  A blank line ends a batch
+                continue;
+            }
+            if ((op != '+' && op != '-') || !(is >> u >> v) || u < 0 || v < 0 || (op == '+' && (is >> w, w <= 0))) {
+                fprintf(stderr, "Error: Invalid update at line %zu of %s\n", ln, upath.c_str());
+                return -1;
+            }
+            (op == '+' ? ins : del).emplace_back(label(u), label(v), w);
+        }
+        flush();
+        const auto& st = inc.stats;
+        fprintf(stderr, "Incremental: %llu batches, %llu arcs inserted (%llu backward), %llu deleted, "
+            "%llu windows of %llu vertices, %llu endpoints sifted, %llu full solves\n",
+            (unsigned long long)st.batches, (unsigned long long)st.inserted, (unsigned long long)st.backward,
+            (unsigned long long)st.deleted, (unsigned long long)st.windows, (unsigned long long)st.window_vertices,
+            (unsigned long long)st.sifted, (unsigned long long)st.full_solves);
+        rk = inc.ordering();
+        for (vertex_id v = vertex_map.size(); v < (vertex_id)rk.size(); ++v)
+            vertex_map.push_back(v);
+    }
+
+    if (!opath.empty())
+        write_solution(opath, rk);
 
-    if (!opath.empty()) {
-        ofstream ofs(opath);
-        for (vertex_id i = 0; i < g.num_vertices(); ++i)
-            ofs << rk[vertex_map[i]] << " \n"[i + 1 == g.num_vertices()];
+    if (!ppath.empty() && !util::profile::report(ppath)) {
+        fprintf(stderr, "Error: Can not write profile %s\n", ppath.c_str());
+        return -1;
     }
+    else if (ppath.empty() && perf)
+        util::profile::report_csv(cerr);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include <bits/stdc++.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <graph/static.hpp>
+#include <graph/edge_list.hpp>
+#include <graph/io.hpp>
+#include <FAS/common.hpp>
+#include <FAS/dispatch.hpp>
+using namespace std;
+
+using namespace graph;
+using namespace util;
+using namespace FAS;
+
+//  Parse a list of integers such as 1-10 or 1,3,5-7. Returns false if invalid.
+bool parse_seeds(const string& str, vector<long long>& seeds) {
+    stringstream ss(str);
+    string item;
+    while (getline(ss, item, ',')) {
+        long long a, b;
+        char c;
+        istringstream is(item);
+        if (!(is >> a)) return false;
+        b = a;
+        if (is >> c && (c != '-' || !(is >> b) || b < a)) return false;
+        if (is >> c) return false;
+        for (long long s = a; s <= b; ++s)
+            seeds.push_back(s);
+    }
+    return !seeds.empty();
+}
+
+//  Size of the address space of this process in bytes, 0 if unknown
+size_t address_space() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long long pages = 0;
+    if (fscanf(f, "%llu", &pages) != 1) pages = 0;
+    fclose(f);
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+//  usage: fas_batch InputGraphPath InputGraphType AlgName[,AlgName...] [-s Seeds] [-p] [-w MaxWeight] [-q Ratio] [-a Slack] [-f Flatness] [-l TimeLimit] [-j Jobs] [-m MemoryLimit] [-t Threads]
+int main(int argc, char** argv) {
+    typedef static_graph<int, int, long long> graph;
+    typedef vertex_id_t<graph> vertex_id;
+    typedef edge_weight_t<graph> edge_weight;
+    if (argc < 4) {
+        fprintf(stderr, "Not enough arguments!\n Usage: fas_batch InputGraphPath InputGraphType AlgName[,AlgName...] [-s Seeds] [-p] [-w MaxWeight] [-q Ratio] [-a Slack] [-f Flatness] [-l TimeLimit] [-j Jobs] [-m MemoryLimit] [-t Threads]");
+        exit(-1);
+    }
+    string graph_path = argv[1], graph_type = argv[2];
+    vector<string> algs;
+    {
+        stringstream ss(argv[3]);
+        string a;
+        while (getline(ss, a, ','))
+            if (!a.empty()) algs.push_back(a);
+    }
+
+    //  The graph column of the result tables has no extension
+    string graph_name = graph_path.substr(graph_path.find_last_of("/\\") + 1);
+    graph_name = graph_name.substr(0, graph_name.find_last_of('.'));
+
+    int maxw = 1;
+    vector<long long> seeds;
+    bool do_shuffle = false;
+    solve_options<graph> opt;
+    unsigned jobs = 0, threads = 1;
+    size_t mem_limit = 0;
+    {
+        int i = 4;
+        while (i < argc) {
+            if (argv[i] == "-s"s) {
+                ++i;
+                if (i >= argc || !parse_seeds(argv[i], seeds)) {
+                    fprintf(stderr, "Error: Invalid list of seeds!\n");
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-p"s) {
+                do_shuffle = true;
+                ++i;
+            }
+            else if (argv[i] == "-w"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Maximum weight must not be empty!\n");
+                    return -1;
+                }
+                maxw = atoi(argv[i]);
+                ++i;
+            }
+            else if (argv[i] == "-q"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Split ratio must not be empty!\n");
+                    return -1;
+                }
+                opt.ratio = parse_ratio(argv[i]);
+                if (opt.ratio <= 0) {
+                    fprintf(stderr, "Error: Invalid split ratio %s\n", argv[i]);
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-a"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Slack must not be empty!\n");
+                    return -1;
+                }
+                opt.slack = parse_slack(argv[i]);
+                if (opt.slack < 0) {
+                    fprintf(stderr, "Error: Invalid split slack %s\n", argv[i]);
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-f"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Flatness must not be empty!\n");
+                    return -1;
+                }
+                opt.flat = parse_flatness(argv[i]);
+                if (opt.flat < 0) {
+                    fprintf(stderr, "Error: Invalid flatness %s, it must be between 0 and 1\n", argv[i]);
+                    return -1;
+                }
+                ++i;
+            }
+            else if (argv[i] == "-l"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Time limit must not be empty!\n");
+                    return -1;
+                }
+                opt.time_limit = atof(argv[i]);
+                ++i;
+            }
+            else if (argv[i] == "-j"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Number of jobs must not be empty!\n");
+                    return -1;
+                }
+                jobs = max(1, atoi(argv[i]));
+                ++i;
+            }
+            else if (argv[i] == "-m"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Memory limit must not be empty!\n");
+                    return -1;
+                }
+                mem_limit = size_t(max(0.0, atof(argv[i])) * 1048576);
+                ++i;
+            }
+            else if (argv[i] == "-t"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Number of threads must not be empty!\n");
+                    return -1;
+                }
+                threads = max(1, atoi(argv[i]));
+                ++i;
+            }
+            else {
+                fprintf(stderr, "Error: Unrecognized option %s\n", argv[i]);
+                return -1;
+            }
+        }
+    }
+    if (algs.empty()) {
+        fprintf(stderr, "Error: No algorithm given!\n");
+        return -1;
+    }
+    if (seeds.empty())
+        seeds.push_back(0);
+    if (jobs == 0)
+        jobs = max(1u, num_threads() / threads);
+
+    //  The base graph is read once, with all threads. Each seed of -p or -w derives its
+    //  variant from the arcs in the order they were read, exactly as fas_alg does.
+    const bool variants = do_shuffle || maxw > 1;
+    graph base;
+    vertex_id n = 0;
+    vector<graph::edge_type> es;
+    if (graph_type == "BIN" && !variants) {
+        read_stats rs;
+        if (!load_graph_bin(base, graph_path, &rs)) {
+            fprintf(stderr, "Error: Can not load binary graph %s\n", graph_path.c_str());
+            return -1;
+        }
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            graph_name.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
+    }
+    else {
+        read_stats rs;
+        auto res = read_graph_impl<graph>(graph_path, graph_type, &rs);
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            graph_name.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
+        n = res.first;
+        if (variants)
+            es = move(res.second);
+        else
+            base = graph(n, res.second.begin(), res.second.end());
+    }
+    set_num_threads(threads);
+
+    //  Each job runs in a child process, which shares the graph with this one until either
+    //  writes to it, and has its address space limited to that of this process plus mem_limit.
+    //  It reports its result through a pipe.
+    struct job {
+        string alg;
+        long long seed;
+        int fd;
+    };
+    map<pid_t, job> running;
+    printf("Graph\tAlgorithm\tRandomSeed\tSolution\tTime\n");
+    fflush(stdout);
+
+    auto wait_one = [&]() {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        auto it = running.find(pid);
+        if (it == running.end()) return;
+        const job& j = it->second;
+        long long w = -1, ms = 0;
+        FILE* f = fdopen(j.fd, "r");
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && fscanf(f, "%lld %lld", &w, &ms) == 2;
+        fclose(f);
+        if (!ok) {
+            w = -1;
+            if (WIFSIGNALED(status))
+                fprintf(stderr, "Error: %s with seed %lld was killed by signal %d%s\n", j.alg.c_str(), j.seed,
+                    WTERMSIG(status), mem_limit > 0 ? ", possibly out of memory" : "");
+            else if (WIFEXITED(status) && WEXITSTATUS(status) == 2)
+                fprintf(stderr, "Error: %s with seed %lld ran out of memory\n", j.alg.c_str(), j.seed);
+            else
+                fprintf(stderr, "Error: %s with seed %lld failed\n", j.alg.c_str(), j.seed);
+        }
+        printf("%s\t%s\t%lld\t%lld\t%lld\n", graph_name.c_str(), j.alg.c_str(), j.seed, w, ms);
+        fflush(stdout);
+        running.erase(it);
+    };
+
+    auto launch = [&](const graph& g, const string& alg, long long seed) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            fprintf(stderr, "Error: Can not create a pipe for %s with seed %lld\n", alg.c_str(), seed);
+            return;
+        }
+        const size_t limit = mem_limit > 0 ? address_space() + mem_limit : 0;
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid < 0) {
+            fprintf(stderr, "Error: Can not start %s with seed %lld\n", alg.c_str(), seed);
+            close(fds[0]);
+            close(fds[1]);
+            return;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            if (limit > 0) {
+                rlimit rl;
+                rl.rlim_cur = rl.rlim_max = limit;
+                setrlimit(RLIMIT_AS, &rl);
+            }
+            try {
+                solve_options<graph> o = opt;
+                o.seed = seed;
+                solution<graph> rk;
+                chrono::system_clock::time_point t_start = chrono::system_clock::now();
+                if (!solve_by_name(g, alg, o, rk))
+                    _exit(1);
+                chrono::milliseconds time_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - t_start);
+                dprintf(fds[1], "%lld %lld\n", (long long)get_fas_weight(g, rk), (long long)time_elapsed.count());
+                _exit(0);
+            }
+            catch (const bad_alloc&) {
+                _exit(2);
+            }
+        }
+        close(fds[1]);
+        running[pid] = { alg, seed, fds[0] };
+    };
+
+    for (long long seed : seeds) {
+        graph variant;
+        if (variants) {
+            vector<graph::edge_type> ves = es;
+            vector<int> vertex_map(n);
+            iota(vertex_map.begin(), vertex_map.end(), 0);
+            mt19937_64 mt(seed);
+            if (maxw > 1) {
+                uniform_int_distribution<edge_weight> uid(1, maxw);
+                for (graph::edge_type& e : ves)
+                    e.weight = uid(mt);
+            }
+            if (do_shuffle) {
+                shuffle(ves.begin(), ves.end(), mt);
+                shuffle(vertex_map.begin(), vertex_map.end(), mt);
+                for (graph::edge_type& e : ves) {
+                    e.src = vertex_map[e.src];
+                    e.dst = vertex_map[e.dst];
+                }
+            }
+            variant = graph(n, ves.begin(), ves.end());
+        }
+        for (const string& alg : algs) {
+            while (running.size() >= jobs)
+                wait_one();
+            launch(variants ? variant : base, alg, seed);
+        }
+    }
+    while (!running.empty())
+        wait_one();
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <bits/stdc++.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+//  Path to the same file from any working directory. Only the directory is resolved, so that
+//  the row names a link to a graph as fas_alg does. Returns an empty string if it does not exist.
+string absolute_path(const string& path) {
+    const size_t p = path.find_last_of('/');
+    const string dir = p == string::npos ? "." : p == 0 ? "/" : path.substr(0, p);
+    char* d = realpath(dir.c_str(), nullptr);
+    if (d == nullptr) return "";
+    string res = d;
+    free(d);
+    if (res.back() != '/') res += '/';
+    return res + path.substr(p == string::npos ? 0 : p + 1);
+}
+
+//  usage: fas_client SocketPath solve InputGraphPath InputGraphType AlgName [-r Seed] [-p] [-w MaxWeight] [-q Ratio] [-a Slack] [-f Flatness] [-l TimeLimit] [-o OutputSolutionPath]
+//         fas_client SocketPath reduce InputGraphPath InputGraphType AlgName [-r Seed] [-p] [-w MaxWeight]
+//         fas_client SocketPath stats|shutdown
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Not enough arguments!\n Usage: fas_client SocketPath solve|reduce InputGraphPath InputGraphType AlgName [Flags] [-o OutputSolutionPath]");
+        exit(-1);
+    }
+    string socket_path = argv[1], request, opath;
+    for (int i = 2; i < argc; ++i) {
+        if (argv[i] == "-o"s) {
+            ++i;
+            if (i >= argc) {
+                fprintf(stderr, "Error: Output path must not be empty!\n");
+                return -1;
+            }
+            opath = argv[i];
+            request += " -k";
+        }
+        else if (i == 3 && (argv[2] == "solve"s || argv[2] == "reduce"s)) {
+            //  The server has its own working directory
+            const string path = absolute_path(argv[i]);
+            if (path.empty()) {
+                fprintf(stderr, "Error: Can not find %s\n", argv[i]);
+                return -1;
+            }
+            request += ' ' + path;
+        }
+        else {
+            if (i > 2) request += ' ';
+            request += argv[i];
+        }
+    }
+    request += '\n';
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long!\n", socket_path.c_str());
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: Can not connect to %s\n", socket_path.c_str());
+        return -1;
+    }
+    for (size_t p = 0; p < request.size();) {
+        ssize_t k = write(fd, request.data() + p, request.size() - p);
+        if (k < 0) {
+            fprintf(stderr, "Error: Can not send the request\n");
+            return -1;
+        }
+        p += k;
+    }
+    shutdown(fd, SHUT_WR);
+
+    FILE* in = fdopen(fd, "r");
+    char* buf = nullptr;
+    size_t cap = 0;
+    ssize_t len = getline(&buf, &cap, in);
+    if (len <= 0) {
+        fprintf(stderr, "Error: No response from the server\n");
+        return -1;
+    }
+    string line(buf, len);
+    if (line.compare(0, 6, "error ") == 0) {
+        fprintf(stderr, "Error: %s", line.c_str() + 6);
+        return -1;
+    }
+    //  The row of fas_alg or fas_red, or the counters of stats
+    if (line.size() > 3)
+        printf("%s", line.c_str() + 3);
+    if (!opath.empty()) {
+        len = getline(&buf, &cap, in);
+        if (len <= 0) {
+            fprintf(stderr, "Error: The ordering is missing from the response\n");
+            return -1;
+        }
+        ofstream ofs(opath);
+        ofs.write(buf, len);
+    }
+    free(buf);
+    fclose(in);
+    return 0;
+}
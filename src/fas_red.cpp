@@ -6,54 +6,20 @@
 #include <FAS/greedy.hpp>
 #include <FAS/reduction.hpp>
 #include <FAS/HCS.hpp>
+#include <FAS/dispatch.hpp>
 using namespace std;
 
 using namespace graph;
 using namespace util;
 using namespace FAS;
 
-template<class Graph>
-solution<Graph> count_edges(const Graph& g, edge_id_t<Graph>& m, edge_weight_t<Graph>& w) {
-    m += g.num_edges();
-    w += get_edge_weight_sum(g);
-    return trivial_solver(g);
-}
-
-template<class Graph, class Solver>
-solution<Graph> solve_after_2cyc_SCC(const Graph& g, Solver s) {
-    vector<edge_t<Graph>> es;
-    es.reserve(g.num_edges());
-    for (const edge_t<Graph>& e : g.edges()) {
-        if ((e.src) < (e.dst))
-            es.push_back(e);
-        else if ((e.src) > (e.dst))
-            es.push_back(edge_t<Graph>{ e.dst, e.src, -e.weight });
-    }
-
-    es.erase(merge_parallel_edges(es.begin(), es.end(), weight_add<edge_t<Graph>>), es.end());
-    es.erase(remove_if(es.begin(), es.end(), [](const edge_t<Graph>& e) { return e.weight == 0; }), es.end());
-    for (edge_t<Graph>& e : es)
-        if ((e.weight) < 0) {
-            swap(e.src, e.dst);
-            e.weight = -e.weight;
-        }
-
-    Graph h(g.num_vertices(), es.begin(), es.end());
-    coloring_result<Graph> color = strongly_connected_components(h);
-    es.clear();
-    for (auto e : g.edges())
-        if (color.second[e.src] == color.second[e.dst])
-            es.push_back(e);
-    return s(Graph(g.num_vertices(), es.begin(), es.end()));
-}
-
-//  usage: fas_red InputGraphPath InputGraphType Algname [-r Seed] [-p] [-w MaxWeight]
+//  usage: fas_red InputGraphPath InputGraphType Algname [-r Seed] [-p] [-w MaxWeight] [-t Threads] [-P ProfilePath] [--perf] [-o OutputGraphPath]
 int main(int argc, char** argv) {
     typedef static_graph<int, int, long long> graph;
     typedef vertex_id_t<graph> vertex_id;
     typedef edge_weight_t<graph> edge_weight;
     if (argc < 4) {
-        fprintf(stderr, "Not enough arguments!\n Usage: fas_red InputGraphPath InputGraphType Algname [-r Seed] [-p] [-w MaxWeight]");
+        fprintf(stderr, "Not enough arguments!\n Usage: fas_red InputGraphPath InputGraphType Algname [-r Seed] [-p] [-w MaxWeight] [-t Threads] [-P ProfilePath] [--perf] [-o OutputGraphPath]");
         exit(-1);
     }
     string alg_name = argv[3], graph_path = argv[1], graph_type = argv[2];
@@ -70,6 +36,8 @@ int main(int argc, char** argv) {
     long long seed = 0;
     bool seed_provided = false;
     bool do_shuffle = false;
+    string opath, ppath;
+    bool perf = false;
     {
         int i = 4;
         while (i < argc) {
@@ -87,6 +55,15 @@ int main(int argc, char** argv) {
                 do_shuffle = true;
                 ++i;
             }
+            else if (argv[i] == "-t"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Number of threads must not be empty!\n");
+                    return -1;
+                }
+                set_num_threads(atoi(argv[i]));
+                ++i;
+            }
             else if (argv[i] == "-w"s) {
                 ++i;
                 if (i >= argc) {
@@ -96,6 +73,28 @@ int main(int argc, char** argv) {
                 maxw = atoi(argv[i]);
                 ++i;
             }
+            else if (argv[i] == "-P"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Profile path must not be empty!\n");
+                    return -1;
+                }
+                ppath = argv[i];
+                ++i;
+            }
+            else if (argv[i] == "--perf"s) {
+                perf = true;
+                ++i;
+            }
+            else if (argv[i] == "-o"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Output path must not be empty!\n");
+                    return -1;
+                }
+                opath = argv[i];
+                ++i;
+            }
             else {
                 fprintf(stderr, "Error: Unrecognized option %s\n", argv[i]);
                 return -1;
@@ -104,11 +103,29 @@ int main(int argc, char** argv) {
     }
 
     vector<int> vertex_map;
+    if (!ppath.empty() || perf)
+        util::profile::enable();
+    if (perf && !util::profile::enable_hw())
+        fprintf(stderr, "Warning: Hardware counters are not available (%s), only times are reported\n", strerror(errno));
 
     graph g;
-    {
-        ifstream ifs(graph_path);
-        auto res = read_graph_impl<graph>(ifs, graph_type);
+    if (graph_type == "BIN" && !do_shuffle && maxw <= 1) {
+        //  Use the arrays of the binary file in place
+        read_stats rs;
+        if (!load_graph_bin(g, graph_path, &rs)) {
+            fprintf(stderr, "Error: Can not load binary graph %s\n", graph_path.c_str());
+            return -1;
+        }
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            graph_name.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
+        vertex_map.assign(g.num_vertices(), 0);
+        iota(vertex_map.begin(), vertex_map.end(), 0);
+    }
+    else {
+        read_stats rs;
+        auto res = read_graph_impl<graph>(graph_path, graph_type, &rs);
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            graph_name.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
         vertex_map.assign(res.first, 0);
         iota(vertex_map.begin(), vertex_map.end(), 0);
 
@@ -136,6 +153,19 @@ int main(int argc, char** argv) {
 
         g = graph(res.first, res.second.begin(), res.second.end());
     }
+    if (alg_name == "convert") {
+        if (opath.empty()) {
+            fprintf(stderr, "Error: Output path must be given with -o when converting!\n");
+            return -1;
+        }
+        if (!g.save(opath)) {
+            fprintf(stderr, "Error: Can not write binary graph %s\n", opath.c_str());
+            return -1;
+        }
+        fprintf(stderr, "Wrote %s: %d vertices and %d edges\n", opath.c_str(), g.num_vertices(), g.num_edges());
+        return 0;
+    }
+
     string task_name = graph_name + "_" + alg_name + "_" + to_string(maxw) + "_" + to_string(seed);
     // fprintf(stderr, "Task name: %s\n", task_name.c_str());
     // fprintf(stderr, "Read complete! %d vertices and %d edges\n", g.num_vertices(), g.num_edges());
@@ -143,46 +173,10 @@ int main(int argc, char** argv) {
     edge_id_t<graph> res_m = 0;
     edge_weight_t<graph> res_w = 0;
     chrono::system_clock::time_point t_start = chrono::system_clock::now();
-    if (alg_name == "HCS") {
-        HCS<graph> red;
-        red.solve(g, bind(count_edges<graph>, _1, ref(res_m), ref(res_w)));
-    }
-    else if (alg_name == "loops") {
-        res_w = get_edge_weight_sum(g);
-        res_m = g.num_edges();
-        for (const edge_t<graph>& e : g.edges())
-            if (e.src == e.dst) {
-                res_m--;
-                res_w -= e.weight;
-            }
-        
-    }
-    else if (alg_name == "scc") {
-        auto color = strongly_connected_components(g);
-        for (auto e : g.edges())
-            if (color.second[e.src] == color.second[e.dst]) {
-                res_m++;
-                res_w += e.weight;
-            }
-    }
-    else if (alg_name == "scc+2cyc") {
-        solve_after_2cyc_SCC(g, bind(count_edges<graph>, _1, ref(res_m), ref(res_w)));
-    }
-    else if (alg_name == "scc+2cyc+chain") {
-        fastred<graph, false, true, true> red;
-        red.solve(g, bind(count_edges<graph>, _1, ref(res_m), ref(res_w)));
-    }
-    else if (alg_name == "RED") {
-        fastred<graph, false, true, false> red;
-        red.solve(g, bind(count_edges<graph>, _1, ref(res_m), ref(res_w)));
-    }
-    else if (alg_name == "REDstar") {
-        fastred<graph, true, true, false> red;
-        red.solve(g, bind(count_edges<graph>, _1, ref(res_m), ref(res_w)));
-    }
-    else {
-        fprintf(stderr, "Invalid algorithm name.\n");
-        exit(-1);
+    {
+        util::profile::scope prof("reduce");
+        if (!reduce_by_name(g, alg_name, res_m, res_w))
+            exit(-1);
     }
     chrono::system_clock::time_point t_finish = chrono::system_clock::now();
 
@@ -190,5 +184,12 @@ int main(int argc, char** argv) {
 
     printf("%s,%d,%lld,%lld\n", task_name.c_str(), res_m, res_w, time_elapsed.count());
 
+    if (!ppath.empty() && !util::profile::report(ppath)) {
+        fprintf(stderr, "Error: Can not write profile %s\n", ppath.c_str());
+        return -1;
+    }
+    else if (ppath.empty() && perf)
+        util::profile::report_csv(cerr);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,409 @@
+#include <bits/stdc++.h>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <graph/static.hpp>
+#include <graph/edge_list.hpp>
+#include <graph/io.hpp>
+#include <FAS/common.hpp>
+#include <FAS/dispatch.hpp>
+using namespace std;
+
+using namespace graph;
+using namespace util;
+using namespace FAS;
+
+typedef static_graph<int, int, long long> graph_type;
+typedef vertex_id_t<graph_type> vertex_id;
+typedef edge_weight_t<graph_type> edge_weight;
+
+//  A graph as it is given to the algorithms: read from a file, then permuted and weighted
+//  by -p and -w as in fas_alg. vertex_map[i] is the vertex of the graph for vertex i of the file.
+struct cached_graph {
+    graph_type g;
+    vector<int> vertex_map;
+};
+
+//  Graph path, type, modification time in nanoseconds, -p, -w and -r
+typedef tuple<string, string, long long, bool, int, long long> graph_key;
+
+//  LRU cache of the graphs, holding at most capacity of them. A graph is loaded by the first
+//  request for it, and the requests for it that arrive meanwhile wait for that load. Graphs
+//  evicted while requests use them are freed when the last of these requests completes.
+//  A file that changes gets a new key, and the graphs of its older versions are dropped.
+class graph_cache {
+    typedef shared_ptr<const cached_graph> pointer;
+    typedef shared_future<pointer> future;
+
+    size_t capacity;
+    mutex m;
+    list<graph_key> lru;
+    map<graph_key, pair<future, list<graph_key>::iterator>> entries;
+
+    static pointer load(const graph_key& key) {
+        const auto& [path, type, mtime, do_shuffle, maxw, seed] = key;
+        auto res = make_shared<cached_graph>();
+        graph_type& g = res->g;
+        vector<int>& vertex_map = res->vertex_map;
+        read_stats rs;
+        if (type == "BIN" && !do_shuffle && maxw <= 1) {
+            //  Use the arrays of the binary file in place
+            if (!load_graph_bin(g, path, &rs))
+                return nullptr;
+            vertex_map.assign(g.num_vertices(), 0);
+            iota(vertex_map.begin(), vertex_map.end(), 0);
+        }
+        else {
+            auto es = read_graph_impl<graph_type>(path, type, &rs);
+            if (es.first == 0 && es.second.empty() && rs.bytes == 0)
+                return nullptr;
+            vertex_map.assign(es.first, 0);
+            iota(vertex_map.begin(), vertex_map.end(), 0);
+            mt19937_64 mt(seed);
+            if (maxw > 1) {
+                uniform_int_distribution<edge_weight> uid(1, maxw);
+                for (graph_type::edge_type& e : es.second)
+                    e.weight = uid(mt);
+            }
+            if (do_shuffle) {
+                shuffle(es.second.begin(), es.second.end(), mt);
+                shuffle(vertex_map.begin(), vertex_map.end(), mt);
+                for (graph_type::edge_type& e : es.second) {
+                    e.src = vertex_map[e.src];
+                    e.dst = vertex_map[e.dst];
+                }
+            }
+            g = graph_type(es.first, es.second.begin(), es.second.end());
+        }
+        fprintf(stderr, "Read %s: %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            path.c_str(), rs.bytes / 1e6, rs.seconds, rs.throughput(), rs.threads);
+        return res;
+    }
+
+public:
+    atomic<uint64_t> hits{ 0 }, misses{ 0 };
+
+    explicit graph_cache(size_t capacity_) : capacity(max<size_t>(1, capacity_)) {}
+
+    //  The graph of key, or nullptr if it can not be read
+    pointer get(const graph_key& key) {
+        promise<pointer> p;
+        future f;
+        {
+            lock_guard<mutex> l(m);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                ++hits;
+                lru.splice(lru.begin(), lru, it->second.second);
+                f = it->second.first;
+            }
+            else {
+                ++misses;
+                for (auto i = lru.begin(); i != lru.end();)
+                    if (std::get<0>(*i) == std::get<0>(key) && std::get<1>(*i) == std::get<1>(key) && std::get<2>(*i) != std::get<2>(key)) {
+                        entries.erase(*i);
+                        i = lru.erase(i);
+                    }
+                    else
+                        ++i;
+                while (lru.size() >= capacity) {
+                    entries.erase(lru.back());
+                    lru.pop_back();
+                }
+                lru.push_front(key);
+                entries.emplace(key, make_pair(future(p.get_future()), lru.begin()));
+            }
+        }
+        if (f.valid())
+            return f.get();
+        pointer g;
+        try {
+            g = load(key);
+        }
+        catch (...) {
+            g = nullptr;
+        }
+        p.set_value(g);
+        if (!g) {
+            //  Let the next request try again
+            lock_guard<mutex> l(m);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                lru.erase(it->second.second);
+                entries.erase(it);
+            }
+        }
+        return g;
+    }
+
+    size_t size() {
+        lock_guard<mutex> l(m);
+        return entries.size();
+    }
+};
+
+bool write_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t k = write(fd, p, n);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += k;
+        n -= k;
+    }
+    return true;
+}
+
+bool write_all(int fd, const string& s) { return write_all(fd, s.data(), s.size()); }
+
+//  The ordering in the format of the output file of fas_alg, written in blocks
+bool write_ordering(int fd, const solution<graph_type>& rk, const vector<int>& vertex_map) {
+    string buf;
+    const size_t n = rk.size();
+    for (size_t i = 0; i < n; ++i) {
+        buf += to_string(rk[vertex_map[i]]);
+        buf += " \n"[i + 1 == n];
+        if (buf.size() >= (1 << 16)) {
+            if (!write_all(fd, buf)) return false;
+            buf.clear();
+        }
+    }
+    if (n == 0) buf = "\n";
+    return write_all(fd, buf);
+}
+
+atomic<bool> stopping{ false };
+int listen_fd = -1;
+
+//  Requests are lines of the form
+//      solve InputGraphPath InputGraphType AlgName [-r Seed] [-p] [-w MaxWeight] [-q Ratio] [-a Slack] [-f Flatness] [-l TimeLimit] [-k]
+//      reduce InputGraphPath InputGraphType AlgName [-r Seed] [-p] [-w MaxWeight]
+//      stats
+//      shutdown
+//  answered by "ok " followed by the row printed by fas_alg or fas_red, and with -k by a second
+//  line with the ordering, or by "error " followed by a message.
+bool handle(int fd, const string& line, graph_cache& cache) {
+    vector<string> tok;
+    {
+        istringstream is(line);
+        string t;
+        while (is >> t)
+            tok.push_back(t);
+    }
+    if (tok.empty()) return true;
+    auto error = [&](const string& msg) { return write_all(fd, "error " + msg + "\n"); };
+    const string& cmd = tok[0];
+    if (cmd == "stats")
+        return write_all(fd, "ok " + to_string(cache.hits.load()) + "," + to_string(cache.misses.load()) + "," + to_string(cache.size()) + "\n");
+    if (cmd == "shutdown") {
+        stopping = true;
+        shutdown(listen_fd, SHUT_RDWR);
+        return write_all(fd, "ok\n");
+    }
+    if (cmd != "solve" && cmd != "reduce")
+        return error("Unknown command " + cmd);
+    if (tok.size() < 4)
+        return error("Not enough arguments");
+    const string &graph_path = tok[1], &type = tok[2], &alg_name = tok[3];
+    const bool solve = cmd == "solve";
+
+    int maxw = 1;
+    long long seed = 0;
+    bool do_shuffle = false, want_ordering = false;
+    solve_options<graph_type> opt;
+    for (size_t i = 4; i < tok.size(); ++i) {
+        const string& f = tok[i];
+        const bool has_arg = i + 1 < tok.size();
+        if (f == "-p")
+            do_shuffle = true;
+        else if (f == "-k" && solve)
+            want_ordering = true;
+        else if (f == "-r" && has_arg)
+            seed = atoll(tok[++i].c_str());
+        else if (f == "-w" && has_arg)
+            maxw = atoi(tok[++i].c_str());
+        else if (f == "-q" && has_arg && solve) {
+            opt.ratio = parse_ratio(tok[++i]);
+            if (opt.ratio <= 0)
+                return error("Invalid split ratio " + tok[i]);
+        }
+        else if (f == "-a" && has_arg && solve) {
+            opt.slack = parse_slack(tok[++i]);
+            if (opt.slack < 0)
+                return error("Invalid split slack " + tok[i]);
+        }
+        else if (f == "-f" && has_arg && solve) {
+            opt.flat = parse_flatness(tok[++i]);
+            if (opt.flat < 0)
+                return error("Invalid flatness " + tok[i] + ", it must be between 0 and 1");
+        }
+        else if (f == "-l" && has_arg && solve)
+            opt.time_limit = atof(tok[++i].c_str());
+        else
+            return error("Unrecognized option " + f);
+    }
+    opt.seed = seed;
+
+    struct stat st;
+    if (stat(graph_path.c_str(), &st) != 0 && (type != "BV" || stat((graph_path + ".graph").c_str(), &st) != 0))
+        return error("Can not open " + graph_path);
+    const long long mtime = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    const bool variant = do_shuffle || maxw > 1;
+    auto cg = cache.get(graph_key(graph_path, type, mtime, do_shuffle, max(maxw, 1), variant ? seed : 0));
+    if (!cg)
+        return error("Can not read " + graph_path);
+    const graph_type& g = cg->g;
+
+    const size_t pos_sec = graph_path.find_last_of("/\\");
+    const string graph_name = pos_sec != string::npos ? graph_path.substr(pos_sec + 1) : graph_path;
+    const string task_name = graph_name + "_" + alg_name + "_" + to_string(maxw) + "_" + to_string(seed);
+
+    chrono::system_clock::time_point t_start = chrono::system_clock::now();
+    if (solve) {
+        solution<graph_type> rk;
+        if (!solve_by_name(g, alg_name, opt, rk))
+            return error("Invalid algorithm name " + alg_name);
+        chrono::milliseconds time_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - t_start);
+        if (!write_all(fd, "ok " + task_name + "," + to_string(get_fas_weight(g, rk)) + "," + to_string(time_elapsed.count()) + "\n"))
+            return false;
+        return !want_ordering || write_ordering(fd, rk, cg->vertex_map);
+    }
+    edge_id_t<graph_type> res_m = 0;
+    edge_weight res_w = 0;
+    if (!reduce_by_name(g, alg_name, res_m, res_w))
+        return error("Invalid algorithm name " + alg_name);
+    chrono::milliseconds time_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now() - t_start);
+    return write_all(fd, "ok " + task_name + "," + to_string(res_m) + "," + to_string(res_w) + "," + to_string(time_elapsed.count()) + "\n");
+}
+
+//  usage: fas_server SocketPath [-j Workers] [-c CacheSize] [-t Threads]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Not enough arguments!\n Usage: fas_server SocketPath [-j Workers] [-c CacheSize] [-t Threads]");
+        exit(-1);
+    }
+    string socket_path = argv[1];
+    unsigned workers = 0, threads = 1;
+    size_t cache_size = 4;
+    {
+        int i = 2;
+        while (i < argc) {
+            if (argv[i] == "-j"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Number of workers must not be empty!\n");
+                    return -1;
+                }
+                workers = max(1, atoi(argv[i]));
+                ++i;
+            }
+            else if (argv[i] == "-c"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Cache size must not be empty!\n");
+                    return -1;
+                }
+                cache_size = max(1, atoi(argv[i]));
+                ++i;
+            }
+            else if (argv[i] == "-t"s) {
+                ++i;
+                if (i >= argc) {
+                    fprintf(stderr, "Error: Number of threads must not be empty!\n");
+                    return -1;
+                }
+                threads = max(1, atoi(argv[i]));
+                ++i;
+            }
+            else {
+                fprintf(stderr, "Error: Unrecognized option %s\n", argv[i]);
+                return -1;
+            }
+        }
+    }
+    if (workers == 0)
+        workers = max(1u, num_threads() / threads);
+    set_num_threads(threads);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long!\n", socket_path.c_str());
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0) {
+        fprintf(stderr, "Error: Can not listen on %s\n", socket_path.c_str());
+        return -1;
+    }
+    //  Clients that hang up must not stop the server
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "Listening on %s with %u workers of %u threads\n", socket_path.c_str(), workers, threads);
+
+    graph_cache cache(cache_size);
+    mutex qm;
+    condition_variable qcv;
+    deque<int> conns;
+    set<int> clients;       //  Connections being served, guarded by qm
+    vector<thread> ts;
+    for (unsigned i = 0; i < workers; ++i)
+        ts.emplace_back([&]() {
+            for (;;) {
+                int fd;
+                {
+                    unique_lock<mutex> l(qm);
+                    qcv.wait(l, [&]() { return stopping || !conns.empty(); });
+                    if (conns.empty()) return;
+                    fd = conns.front();
+                    conns.pop_front();
+                    clients.insert(fd);
+                    if (stopping) shutdown(fd, SHUT_RD);
+                }
+                FILE* in = fdopen(dup(fd), "r");
+                char* buf = nullptr;
+                size_t cap = 0;
+                ssize_t len;
+                while (in && (len = getline(&buf, &cap, in)) > 0) {
+                    if (!handle(fd, string(buf, len), cache) || stopping) break;
+                }
+                free(buf);
+                if (in) fclose(in);
+                {
+                    lock_guard<mutex> l(qm);
+                    clients.erase(fd);
+                }
+                close(fd);
+            }
+        });
+
+    while (!stopping) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR && !stopping) continue;
+            break;
+        }
+        lock_guard<mutex> l(qm);
+        conns.push_back(fd);
+        qcv.notify_one();
+    }
+    {
+        lock_guard<mutex> l(qm);
+        stopping = true;
+        //  Workers waiting for the next request of an idle client read the end of its
+        //  connection instead. Requests it has already sent are still answered.
+        for (int fd : clients)
+            shutdown(fd, SHUT_RD);
+    }
+    qcv.notify_all();
+    for (thread& t : ts)
+        t.join();
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    return 0;
+}
@@ -2,7 +2,7 @@
 #define FAS_HCS_HPP
 #include <list>
 #include <queue>
-#include <ext/pb_ds/assoc_container.hpp>
+#include <util/adjacency_store.hpp>
 #include <graph/scc.hpp>
 #include <graph/algorithms.hpp>
 #include <FAS/common.hpp>
@@ -22,7 +22,7 @@ struct HCS {
     typedef edge_weight_t<Graph> edge_weight;
     typedef edge_t<Graph> edge;
 
-    typedef __gnu_pbds::gp_hash_table<vertex_id, edge_weight> edge_container;
+    typedef util::adjacency_store<vertex_id, edge_weight> edge_container;
 
     enum stat_t { normal = 0, inqueue = 1, deleted = 2 };
 
@@ -34,7 +34,7 @@ struct HCS {
     list<pii> k;
     vector<list<vertex_id>> l;
 
-    vector<edge_container> g, h;
+    edge_container g, h;
 
     typedef pair<vertex_id, edge_weight> pvw;
 
@@ -54,6 +54,14 @@ edge_weight_t<Graph> get_edge_weight_sum(const Graph& g) {
     return wsum;
 }
 
+template<class Graph>
+edge_weight_t<Graph> get_max_edge_weight(const Graph& g) {
+    edge_weight_t<Graph> w = 0;
+    for (const edge_t<Graph>& e : g.edges())
+        w = max(w, e.weight);
+    return w;
+}
+
 template<class Graph>
 edge_weight_t<Graph> get_lo_weight(const Graph& g, const solution<Graph>& rk) {
     edge_weight_t<Graph> wsum = 0;
@@ -0,0 +1,267 @@
+#ifndef FAS_DISPATCH_HPP
+#define FAS_DISPATCH_HPP
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <mutex>
+#include <string>
+#include <graph/algorithms.hpp>
+#include <FAS/common.hpp>
+#include <FAS/greedy.hpp>
+#include <FAS/reduction.hpp>
+#include <FAS/hybrid.hpp>
+#include <FAS/HCS.hpp>
+#include <FAS/local_search.hpp>
+#include <FAS/memetic.hpp>
+#include <FAS/exact.hpp>
+
+namespace FAS {
+
+using std::string;
+
+//  Parse a positive split ratio q, given as a decimal or as a fraction a/b. Returns -1 if invalid.
+inline double parse_ratio(const string& str) {
+    char* end;
+    double a = strtod(str.c_str(), &end);
+    if (*end == '/') {
+        const char* p = end + 1;
+        double b = strtod(p, &end);
+        if (end == p || b <= 0) return -1;
+        a /= b;
+    }
+    if (end == str.c_str() || *end != '\0' || !(a > 0)) return -1;
+    return a;
+}
+
+//  Parse a finite number in [lo, hi] that makes up all of str. Returns -1 if invalid.
+inline double parse_number(const string& str, double lo, double hi) {
+    char* end;
+    errno = 0;
+    double a = strtod(str.c_str(), &end);
+    if (end == str.c_str() || *end != '\0' || errno == ERANGE || !std::isfinite(a) || a < lo || a > hi) return -1;
+    return a;
+}
+
+//  Parse the split slack of -a, at least 0. Returns -1 if invalid.
+inline double parse_slack(const string& str) { return parse_number(str, 0, HUGE_VAL); }
+
+//  Parse the flatness of -f, between 0 and 1. Returns -1 if invalid.
+inline double parse_flatness(const string& str) { return parse_number(str, 0, 1); }
+
+//  Options of the algorithms of fas_alg, set by its flags
+template<class Graph>
+struct solve_options {
+    double ratio = 0;           //  -q
+    double slack = -1;          //  -a
+    double flat = 0;            //  -f
+    bool verbose = false;       //  -v
+    double time_limit = 0;      //  -l
+    long long seed = 0;         //  -r
+    function<void(const solution<Graph>&, edge_weight_t<Graph>)> on_improve;   //  Memetic
+};
+
+//  Solve g with the algorithm named alg_name, as listed in the readme, into rk.
+//  Prints an error and returns false if the name is invalid.
+template<class Graph>
+bool solve_by_name(const Graph& g, string alg_name, const solve_options<Graph>& opt, solution<Graph>& rk) {
+    //  AlgName+LS improves the result of AlgName by local search
+    bool do_local_search = alg_name.size() > 3 && alg_name.compare(alg_name.size() - 3, 3, "+LS") == 0;
+    if (do_local_search)
+        alg_name.resize(alg_name.size() - 3);
+
+    auto run_hybrid = [&](bool rec_scc, double q) {
+        solver_hybrid<Graph> s(rec_scc, q, true);
+        s.slack = opt.slack;
+        s.flat = opt.flat;
+        solution<Graph> res = s.solve(g);
+        if (opt.verbose) {
+            const auto& st = s.stats;
+            fprintf(stderr, "Recursion depth %zu, %llu bisections, %llu flat stops\n", st.subproblems.size(),
+                (unsigned long long)st.bisections, (unsigned long long)st.flat_stops);
+            for (size_t d = 0; d < st.subproblems.size(); ++d)
+                fprintf(stderr, "  depth %zu: %llu subproblems, %llu vertices\n", d,
+                    (unsigned long long)st.subproblems[d], (unsigned long long)st.vertices[d]);
+            for (size_t b = 0; b < st.sizes.size(); ++b)
+                if (st.sizes[b] > 0)
+                    fprintf(stderr, "  size [%llu, %llu): %llu subproblems\n", 1ull << b, 2ull << b,
+                        (unsigned long long)st.sizes[b]);
+        }
+        return res;
+    };
+    //  Greedy on the parts of g uses the heap chosen for g
+    const solver<Graph> gr = solver_greedy<Graph>(greedy_uses_bucket_heap(g));
+    std::smatch mt;
+    if (alg_name == "Greedy")
+        rk = gr(g);
+    else if (alg_name == "scc+Greedy") {
+        coloring_result<Graph> color = strongly_connected_components(g);
+        partition_result<Graph> par = partition(g, color);
+        vector<solution<Graph>> sv;
+        for (const auto& x : par.second)
+            sv.emplace_back(gr(x.second));
+        rk = default_assemble(g.num_vertices(), par, sv);
+    }
+    else if (alg_name == "scc+2cyc+Greedy") {
+        fastred<Graph, false, false, false> red;
+        rk = red.solve(g, gr);
+    }
+    else if (alg_name == "scc+2cyc+chain+Greedy") {
+        fastred<Graph, false, true, true> red;
+        rk = red.solve(g, gr);
+    }
+    else if (alg_name == "RED+Greedy") {
+        fastred<Graph, false> red;
+        rk = red.solve(g, gr);
+    }
+    else if (alg_name == "REDstar+Greedy") {
+        fastred<Graph, true> red;
+        rk = red.solve(g, gr);
+    }
+    else if (alg_name == "HCS+Greedy") {
+        HCS<Graph> red;
+        rk = red.solve(g, gr);
+    }
+    else if (std::regex_match(alg_name, mt, std::regex("(RED|REDstar|HCS)\\+Exact([0-9]+)\\+Greedy"))) {
+        solver_exact<Graph> ex(std::stoi(mt[2]), gr);
+        if (mt[1] == "RED")
+            rk = fastred<Graph, false>().solve(g, ex);
+        else if (mt[1] == "REDstar")
+            rk = fastred<Graph, true>().solve(g, ex);
+        else
+            rk = HCS<Graph>().solve(g, ex);
+        const exact_stats& st = *ex.stats;
+        fprintf(stderr, "Exact: %llu of %llu leaves solved optimally (%llu by DP, %llu by branch and bound, %llu out of nodes)\n",
+            (unsigned long long)(st.dp + st.bb), (unsigned long long)st.leaves.load(), (unsigned long long)st.dp.load(),
+            (unsigned long long)st.bb.load(), (unsigned long long)st.bb_aborted.load());
+    }
+    else if (alg_name == "GreedyDC") {
+        rk = solver_greedyDC<Graph>()(g);
+    }
+    else if (alg_name == "GreedyDC+DP") {
+        rk = solver_greedyDC_merge<Graph>()(g);
+    }
+    else if (alg_name == "RASstar") {
+        rk = run_hybrid(true, 3);
+    }
+    else if (alg_name == "Memetic") {
+        vector<solver<Graph>> seeds = {
+            gr,
+            [](const Graph& x) { return hybrid(x, false, 3, true); },
+            [gr](const Graph& x) { return fastred<Graph, true>().solve(x, gr); },
+        };
+        memetic_search<Graph> ms(seeds, opt.time_limit > 0 ? opt.time_limit : 60, opt.seed);
+        ms.on_improve = opt.on_improve;
+        rk = ms(g);
+    }
+    else if (alg_name.compare(0, 3, "RAS") == 0 && (alg_name.size() > 3 || opt.ratio > 0)) {
+        double q = alg_name.size() > 3 ? parse_ratio(alg_name.substr(3)) : opt.ratio;
+        if (q <= 0) {
+            fprintf(stderr, "Error: Invalid split ratio of %s.\n", alg_name.c_str());
+            return false;
+        }
+        rk = run_hybrid(false, q);
+    }
+    else {
+        fprintf(stderr, "Invalid algorithm name.\n");
+        return false;
+    }
+    if (do_local_search)
+        rk = improver_sifting<Graph>(opt.time_limit)(g, rk);
+    return true;
+}
+
+//  fastred calls the solver from several threads
+template<class Graph>
+solution<Graph> count_edges(const Graph& g, edge_id_t<Graph>& m, edge_weight_t<Graph>& w) {
+    static std::mutex mtx;
+    edge_weight_t<Graph> ws = get_edge_weight_sum(g);
+    {
+        std::lock_guard<std::mutex> l(mtx);
+        m += g.num_edges();
+        w += ws;
+    }
+    return trivial_solver(g);
+}
+
+template<class Graph, class Solver>
+solution<Graph> solve_after_2cyc_SCC(const Graph& g, Solver s) {
+    vector<edge_t<Graph>> es;
+    es.reserve(g.num_edges());
+    for (const edge_t<Graph>& e : g.edges()) {
+        if ((e.src) < (e.dst))
+            es.push_back(e);
+        else if ((e.src) > (e.dst))
+            es.push_back(edge_t<Graph>{ e.dst, e.src, -e.weight });
+    }
+
+    es.erase(merge_parallel_edges(es.begin(), es.end(), weight_add<edge_t<Graph>>), es.end());
+    es.erase(std::remove_if(es.begin(), es.end(), [](const edge_t<Graph>& e) { return e.weight == 0; }), es.end());
+    for (edge_t<Graph>& e : es)
+        if ((e.weight) < 0) {
+            swap(e.src, e.dst);
+            e.weight = -e.weight;
+        }
+
+    Graph h(g.num_vertices(), es.begin(), es.end());
+    coloring_result<Graph> color = strongly_connected_components(h);
+    es.clear();
+    for (auto e : g.edges())
+        if (color.second[e.src] == color.second[e.dst])
+            es.push_back(e);
+    return s(Graph(g.num_vertices(), es.begin(), es.end()));
+}
+
+//  Reduce g with the reduction named alg_name, as listed in the readme, and add the number
+//  and the weight of the arcs left to res_m and res_w.
+//  Prints an error and returns false if the name is invalid.
+template<class Graph>
+bool reduce_by_name(const Graph& g, const string& alg_name, edge_id_t<Graph>& res_m, edge_weight_t<Graph>& res_w) {
+    if (alg_name == "HCS") {
+        HCS<Graph> red;
+        red.solve(g, bind(count_edges<Graph>, _1, std::ref(res_m), std::ref(res_w)));
+    }
+    else if (alg_name == "loops") {
+        res_w = get_edge_weight_sum(g);
+        res_m = g.num_edges();
+        for (const edge_t<Graph>& e : g.edges())
+            if (e.src == e.dst) {
+                res_m--;
+                res_w -= e.weight;
+            }
+    }
+    else if (alg_name == "scc") {
+        auto color = strongly_connected_components(g);
+        for (auto e : g.edges())
+            if (color.second[e.src] == color.second[e.dst]) {
+                res_m++;
+                res_w += e.weight;
+            }
+    }
+    else if (alg_name == "scc+2cyc") {
+        solve_after_2cyc_SCC(g, bind(count_edges<Graph>, _1, std::ref(res_m), std::ref(res_w)));
+    }
+    else if (alg_name == "scc+2cyc+chain") {
+        fastred<Graph, false, true, true> red;
+        red.solve(g, bind(count_edges<Graph>, _1, std::ref(res_m), std::ref(res_w)));
+    }
+    else if (alg_name == "RED") {
+        fastred<Graph, false, true, false> red;
+        red.solve(g, bind(count_edges<Graph>, _1, std::ref(res_m), std::ref(res_w)));
+    }
+    else if (alg_name == "REDstar") {
+        fastred<Graph, true, true, false> red;
+        red.solve(g, bind(count_edges<Graph>, _1, std::ref(res_m), std::ref(res_w)));
+    }
+    else {
+        fprintf(stderr, "Invalid algorithm name.\n");
+        return false;
+    }
+    return true;
+}
+
+}
+
+#endif
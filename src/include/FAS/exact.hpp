@@ -0,0 +1,209 @@
+#ifndef FAS_EXACT_HPP
+#define FAS_EXACT_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <FAS/common.hpp>
+
+namespace FAS {
+
+//  Leaves solved by solver_exact, shared by its copies
+struct exact_stats {
+    std::atomic<std::uint64_t> leaves{ 0 };        //  Graphs given to the solver
+    std::atomic<std::uint64_t> dp{ 0 };            //  Solved optimally by the subset DP
+    std::atomic<std::uint64_t> bb{ 0 };            //  Solved optimally by branch and bound
+    std::atomic<std::uint64_t> bb_aborted{ 0 };    //  Branch and bound out of nodes
+};
+
+//  Exact minimum FAS of small graphs, as a solver that leaves larger graphs to a fallback.
+//  Graphs with at most dp_max vertices: DP over the sets S of vertices placed first,
+//  dp[S] = min over v in S of dp[S \ v] + w(v -> S \ v), in O(2^n n) time and 2^n weights.
+//  The weights w(u -> S) for all u are kept in an array that is updated column by column
+//  as S is enumerated in increasing order, which the compiler vectorizes.
+//  Graphs with at most max_size vertices: depth-first branch and bound over prefixes of
+//  the ordering, starting from the solution of the fallback. A prefix is cut off by the sum
+//  over the remaining pairs of the lighter direction, or if the same set was reached at lower
+//  cost before. A remaining vertex without arcs from the other remaining vertices is placed
+//  next without branching. After node_limit nodes the best ordering found is returned.
+template<class Graph>
+struct solver_exact {
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_weight_t<Graph> edge_weight;
+    typedef std::uint64_t mask;
+
+    static constexpr vertex_id dp_limit = 24;
+    static constexpr vertex_id bb_limit = 64;
+
+    vertex_id dp_max, max_size;
+    solver<Graph> fallback;
+    std::uint64_t node_limit = 1 << 20;
+    std::size_t memo_limit = 1 << 20;
+    std::shared_ptr<exact_stats> stats;
+
+    solver_exact(vertex_id max_size_, solver<Graph> fallback_)
+        : dp_max(std::min(max_size_, dp_limit)), max_size(std::min(max_size_, bb_limit)),
+          fallback(std::move(fallback_)), stats(std::make_shared<exact_stats>()) {}
+
+    //  w[u][v]: total weight of the arcs u -> v, without self-loops
+    static vector<vector<edge_weight>> matrix(const Graph& g) {
+        const vertex_id n = g.num_vertices();
+        vector<vector<edge_weight>> w(n, vector<edge_weight>(n, 0));
+        for (const auto& e : g.edges())
+            if (e.src != e.dst)
+                w[e.src][e.dst] += e.weight;
+        return w;
+    }
+
+    static solution<Graph> subset_dp(const vector<vector<edge_weight>>& w) {
+        const vertex_id n = w.size();
+        //  col[u][v] = w(v -> u)
+        vector<edge_weight> col(n * dp_limit, 0);
+        for (vertex_id u = 0; u < n; ++u)
+            for (vertex_id v = 0; v < n; ++v)
+                col[u * dp_limit + v] = w[v][u];
+        const mask full = (mask(1) << n) - 1;
+        vector<edge_weight> dp(full + 1);
+        edge_weight a[dp_limit] = {};      //  a[v] = w(v -> S)
+        dp[0] = 0;
+        for (mask s = 1; s <= full; ++s) {
+            //  s - 1 -> s clears the trailing ones of s - 1 and sets the next bit
+            const int z = __builtin_ctzll(s);
+            for (int u = 0; u < z; ++u) {
+                const edge_weight* c = &col[u * dp_limit];
+                for (vertex_id v = 0; v < dp_limit; ++v)
+                    a[v] -= c[v];
+            }
+            const edge_weight* c = &col[z * dp_limit];
+            for (vertex_id v = 0; v < dp_limit; ++v)
+                a[v] += c[v];
+            edge_weight best = -1;
+            for (mask t = s; t; t &= t - 1) {
+                const int v = __builtin_ctzll(t);
+                edge_weight x = dp[s ^ (mask(1) << v)] + a[v];
+                if (best == -1 || x < best) best = x;
+            }
+            dp[s] = best;
+        }
+        //  Take the last vertex of every optimal prefix
+        solution<Graph> rk(n);
+        mask s = full;
+        for (vertex_id p = n; p-- > 0;) {
+            for (mask t = s; t; t &= t - 1) {
+                const int v = __builtin_ctzll(t);
+                const mask r = s ^ (mask(1) << v);
+                edge_weight x = dp[r];
+                for (mask q = r; q; q &= q - 1)
+                    x += w[v][__builtin_ctzll(q)];
+                if (x == dp[s]) {
+                    rk[v] = p;
+                    s = r;
+                    break;
+                }
+            }
+        }
+        return rk;
+    }
+
+    struct branch_and_bound {
+        const vector<vector<edge_weight>>& w;
+        vector<vector<edge_weight>> lo;     //  min(w[u][v], w[v][u])
+        vertex_id n;
+        std::uint64_t nodes = 0, node_limit;
+        std::size_t memo_limit;
+        std::unordered_map<mask, edge_weight> memo;
+        vector<vertex_id> path, best_path;
+        edge_weight best;
+
+        branch_and_bound(const vector<vector<edge_weight>>& w_, std::uint64_t node_limit_, std::size_t memo_limit_)
+            : w(w_), n(w_.size()), node_limit(node_limit_), memo_limit(memo_limit_) {
+            lo.assign(n, vector<edge_weight>(n));
+            for (vertex_id u = 0; u < n; ++u)
+                for (vertex_id v = 0; v < n; ++v)
+                    lo[u][v] = min(w[u][v], w[v][u]);
+        }
+
+        //  s: placed vertices, cost: backward weight among them, rest: lower bound on the rest
+        void search(mask s, edge_weight cost, edge_weight rest) {
+            if (cost + rest >= best || ++nodes > node_limit) return;
+            const vertex_id k = path.size();
+            if (k == n) {
+                best = cost;
+                best_path = path;
+                return;
+            }
+            auto it = memo.find(s);
+            if (it != memo.end()) {
+                if (it->second <= cost) return;
+                it->second = cost;
+            }
+            else if (memo.size() < memo_limit)
+                memo.emplace(s, cost);
+
+            const mask full = (n == 64 ? ~mask(0) : (mask(1) << n) - 1), r = full & ~s;
+            vector<std::pair<edge_weight, vertex_id>> cand;
+            for (mask t = r; t; t &= t - 1) {
+                const vertex_id v = __builtin_ctzll(t);
+                edge_weight c = 0, in = 0;
+                for (mask q = s; q; q &= q - 1)
+                    c += w[v][__builtin_ctzll(q)];
+                for (mask q = r; q; q &= q - 1)
+                    in += w[__builtin_ctzll(q)][v];
+                if (in == 0) {
+                    cand.assign(1, { c, v });
+                    break;
+                }
+                cand.emplace_back(c, v);
+            }
+            std::sort(cand.begin(), cand.end());
+            for (const auto& [c, v] : cand) {
+                edge_weight d = 0;
+                for (mask q = r; q; q &= q - 1)
+                    d += lo[v][__builtin_ctzll(q)];
+                path.push_back(v);
+                search(s | (mask(1) << v), cost + c, rest - d);
+                path.pop_back();
+                if (nodes > node_limit) return;
+            }
+        }
+    };
+
+    solution<Graph> operator()(const Graph& g) {
+        const vertex_id n = g.num_vertices();
+        ++stats->leaves;
+        if (n > max_size)
+            return fallback(g);
+        const vector<vector<edge_weight>> w = matrix(g);
+        if (n <= dp_max) {
+            ++stats->dp;
+            return subset_dp(w);
+        }
+        solution<Graph> ub = fallback(g);
+        branch_and_bound bb(w, node_limit, memo_limit);
+        bb.best = get_fas_weight(g, ub);
+        for (const auto& e : g.edges())
+            if (e.src == e.dst)
+                bb.best -= e.weight;
+        edge_weight rest = 0;
+        for (vertex_id u = 0; u < n; ++u)
+            for (vertex_id v = u + 1; v < n; ++v)
+                rest += bb.lo[u][v];
+        bb.search(0, 0, rest);
+        if (bb.nodes > node_limit)
+            ++stats->bb_aborted;
+        else
+            ++stats->bb;
+        if (bb.best_path.empty())
+            return ub;
+        solution<Graph> rk(n);
+        for (vertex_id i = 0; i < n; ++i)
+            rk[bb.best_path[i]] = i;
+        return rk;
+    }
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define FAS_SOLVER_GREEDY_HPP
 #include <vector>
 #include <util/histogram_heap.hpp>
+#include <util/profile.hpp>
 #include <FAS/common.hpp>
 #include <FAS/recursive.hpp>
 #include <GB/common.hpp>
@@ -17,14 +18,29 @@ namespace FAS {
 //  T. Coleman, A. Wirth. (2010). 
 //  Ranking tournaments: Local search and a new algorithm. 
 //  Journal of Experimental Algorithmics, 14, 2-6.
-template<class Graph, bool useAbs = false>
+
+//  Graphs with arc weights up to this limit use static_histogram_max_heap, whose
+//  modify_key takes one step per unit of weight. Heavier graphs use static_bucket_max_heap,
+//  which breaks ties between equal keys differently.
+constexpr long long greedy_histogram_heap_weight_limit = 16;
+
+//  Whether Greedy on g, and on every subgraph a solver makes of g, uses static_bucket_max_heap.
+//  The heap is chosen once from the input, since merged and contracted arcs are heavier than
+//  those of the input and the results on light graphs must not depend on the heap.
+template<class Graph>
+bool greedy_uses_bucket_heap(const Graph& g) {
+    return get_max_edge_weight(g) > greedy_histogram_heap_weight_limit;
+}
+
+template<class Graph, bool useAbs = false,
+    class Heap = util::static_histogram_max_heap<edge_weight_t<Graph>, vertex_id_t<Graph>>>
 class greedy_impl {
 public:
     typedef vertex_id_t<Graph> vertex_id;
     typedef edge_weight_t<Graph> edge_weight_type;
     typedef edge_t<Graph> edge_type;
 
-    typedef util::static_histogram_max_heap<edge_weight_type, vertex_id> heap;
+    typedef Heap heap;
 
     const Graph& g;
     vector<char> del;
@@ -137,46 +153,152 @@ public:
 };
 
 template<class Graph>
-solution<Graph> greedy(const Graph& g) {
+using greedy_bucket_heap = util::static_bucket_max_heap<edge_weight_t<Graph>, vertex_id_t<Graph>>;
+
+template<class Graph>
+solution<Graph> greedy_with_heap(const Graph& g, bool bucket_heap) {
+    util::profile::scope prof("greedy");
+    if (bucket_heap)
+        return greedy_impl<Graph, true, greedy_bucket_heap<Graph>>(g).rk;
     greedy_impl<Graph,true> impl(g);
     // vector<vertex_id_t<Graph>> rk = trivial_solver(g);
     return impl.rk;
     // return get_fas_weight(g, rk) < get_fas_weight(g, impl.rk) ? rk : impl.rk;
 }
 
+template<class Graph>
+solution<Graph> greedy(const Graph& g) {
+    return greedy_with_heap(g, greedy_uses_bucket_heap(g));
+}
+
 
 template<class Graph>
 struct decomposer_greedy {
 
     double alpha;
-    decomposer_greedy(double alpha_ = (2. / 3)) : alpha(alpha_) {}
+    bool merge;     //  Assemble with dp_assemble instead of concatenating the halves
+    bool bucket_heap;   //  See greedy_uses_bucket_heap
+    vector<edge_t<Graph>> cut;      //  Arcs between the halves split in place, by original ids, if merge
+    decomposer_greedy(double alpha_ = (2. / 3), bool merge_ = false, bool bucket_heap_ = false)
+        : alpha(alpha_), merge(merge_), bucket_heap(bucket_heap_) {}
 
     partition_result<Graph> decompose(const Graph& g) {
-        typedef vertex_id_t<Graph> vertex_id;
+        if (bucket_heap)
+            return split(g, greedy_impl<Graph, true, greedy_bucket_heap<Graph>>(g));
+        return split(g, greedy_impl<Graph, true>(g));
+    }
+
+    vector<partition_view<Graph>> decompose(partitioned_graph<Graph>& pg, const partition_view<Graph>& x) {
+        typedef partition_view<Graph> view;
+        if (bucket_heap)
+            return split(pg, x, greedy_impl<view, true, greedy_bucket_heap<view>>(x));
+        return split(pg, x, greedy_impl<view, true>(x));
+    }
+
+    //  The first part of the ordering found by Greedy gets color 0, the rest color 1
+    template<class G, class Impl>
+    coloring_result<G> bisect(const G& g, const Impl& impl) {
+        typedef vertex_id_t<G> vertex_id;
         const vertex_id n = g.num_vertices();
-        greedy_impl<Graph, true> impl(g);
         vector<vertex_id> color(n); 
         vertex_id t = min(max(impl.lp, (vertex_id)ceil((1 - alpha) * n)),  (vertex_id)floor(alpha * n));
         for (vertex_id i = 0; i < n; ++i)
             color[i] = impl.rk[i] >= t;
-        return partition(g, coloring_result<Graph>(2, color));
+        return coloring_result<G>(2, color);
+    }
+
+    template<class Impl>
+    partition_result<Graph> split(const Graph& g, const Impl& impl) {
+        return partition(g, bisect(g, impl));
+    }
+
+    //  The halves are ordered as assemble orders them
+    template<class Impl>
+    vector<partition_view<Graph>> split(partitioned_graph<Graph>& pg, const partition_view<Graph>& x, const Impl& impl) {
+        coloring_result<partition_view<Graph>> c = bisect(x, impl);
+        edge_weight_t<Graph> w[2][2] = { { 0, 0 }, { 0, 0 } };
+        for (const edge_t<Graph>& e : x.edges()) {
+            w[c.second[e.src]][c.second[e.dst]] += e.weight;
+            if (merge && c.second[e.src] != c.second[e.dst])
+                cut.emplace_back(x.original_id(e.src), x.original_id(e.dst), e.weight);
+        }
+        vector<partition_view<Graph>> res = pg.split(x, c);
+        if (w[1][0] >= w[0][1])
+            swap(res[0], res[1]);
+        return res;
     }
 
     solution<Graph> assemble(const Graph& g, const partition_result<Graph>& dres, const vector<solution<Graph>>& sres) {
+        if (merge)
+            return dp_assemble(g, dres, sres, solver<Graph>(trivial_solver<Graph>));
         return hybrid_assemble(g, dres, sres, solver<Graph>(trivial_solver<Graph>));
     }
 
+    bool assembles_in_place() const { return merge; }
+
+    //  Optimal merge of the solved halves at positions [p, p + n) of res, by dp_merge on the cut
+    void assemble(const vector<partition_view<Graph>>& parts, vertex_id_t<Graph> p, solution<Graph>& res) {
+        typedef vertex_id_t<Graph> vertex_id;
+        typedef merge_step<vertex_id, edge_weight_t<Graph>> step;
+        const vertex_id n1 = parts[0].num_vertices(), n2 = parts[1].num_vertices();
+        if (n1 == 0 || n2 == 0 || cut.empty()) return;
+        //  seq[i] = vertex at position p + i, the first half before the second
+        vector<vertex_id> seq(n1 + n2);
+        for (const partition_view<Graph>& y : parts)
+            for (vertex_id i = 0; i < y.num_vertices(); ++i)
+                seq[res[y.original_id(i)] - p] = y.original_id(i);
+        vector<step> st;
+        st.reserve(cut.size());
+        for (const edge_t<Graph>& e : cut) {
+            const vertex_id u = res[e.src] - p, v = res[e.dst] - p;
+            if (u >= n1)
+                st.push_back({ v, u - n1 + 1, -e.weight });
+            else
+                st.push_back({ u, v - n1 + 1, e.weight });
+        }
+        vector<edge_t<Graph>>().swap(cut);
+        sort(st.begin(), st.end(), [](const step& x, const step& y) {
+            return x.i < y.i || (x.i == y.i && x.x < y.x);
+        });
+        const vector<vertex_id> before = dp_merge(n1, n2, st);
+        vertex_id q = p, j = 0;
+        for (vertex_id i = 0; i < n1; ++i) {
+            while (j < before[i])
+                res[seq[n1 + j++]] = q++;
+            res[seq[i]] = q++;
+        }
+        while (j < n2)
+            res[seq[n1 + j++]] = q++;
+    }
+
 };
 
 template<class Graph>
 solver<Graph> solver_greedy() { return greedy<Graph>; }
 
+//  Greedy for the subgraphs of an input, with the heap chosen for it by greedy_uses_bucket_heap
+template<class Graph>
+solver<Graph> solver_greedy(bool bucket_heap) {
+    return [bucket_heap](const Graph& g) { return greedy_with_heap(g, bucket_heap); };
+}
+
 template<class Graph>
 solver<Graph> solver_greedyDC() {
     return [=](const Graph& g) {
-        return recurse<Graph>(g,
-            trivial_solver<Graph>, 1,
-            std::make_tuple(decomposer_scc<Graph>(), decomposer_greedy<Graph>()));
+        return recurse_in_place<Graph>(g,
+            trivial_solver<partition_view<Graph>>, 1,
+            std::make_tuple(decomposer_scc<Graph>(), decomposer_greedy<Graph>(2. / 3, false, greedy_uses_bucket_heap(g))));
+    };
+}
+
+//  The halves of each bisection are merged optimally by dp_merge, on the same partitioned copy
+//  of the graph as solver_greedyDC. Only the arcs between the halves are kept for the merge.
+template<class Graph>
+solver<Graph> solver_greedyDC_merge() {
+    return [=](const Graph& g) {
+        return recurse_in_place<Graph>(g,
+            trivial_solver<partition_view<Graph>>, 1,
+            std::make_tuple(decomposer_scc<Graph>(), decomposer_greedy<Graph>(2. / 3, true, greedy_uses_bucket_heap(g))));
     };
 }
 
@@ -2,11 +2,14 @@
 #define FAS_HYBRID_HPP
 #include <list>
 #include <queue>
-#include <ext/pb_ds/assoc_container.hpp>
+#include <util/adjacency_store.hpp>
 #include <util/histogram_heap.hpp>
+#include <util/profile.hpp>
+#include <util/work_stealing.hpp>
 #include <graph/scc.hpp>
 #include <graph/algorithms.hpp>
 #include <FAS/common.hpp>
+#include <FAS/greedy.hpp>
 
 
 namespace FAS {
@@ -16,14 +19,68 @@ using std::queue;
 using std::list;
 using std::priority_queue;
 
-template<class Graph, bool RecSCC, int P, bool useAbs>
+//  rec_scc: split every component into its SCCs before bisecting it.
+//  q: both sides of a bisection keep at least 1/q of the vertices, no bound if q <= 0.
+//  use_abs: rank by GreedyAbs instead of Greedy.
+//  Adaptive split, when slack >= 0: among the cuts of the window whose backward weight is at
+//  most (1 + slack) times the minimum of the window, take the most balanced one. A component
+//  whose cut weights differ by at most flat times their maximum keeps its Greedy ordering
+//  instead of being split further.
+template<class Graph>
 struct solver_hybrid {
 
     typedef vertex_id_t<Graph> vertex_id;
     typedef edge_weight_t<Graph> edge_weight;
     typedef edge_t<Graph> edge;
 
-    typedef __gnu_pbds::gp_hash_table<vertex_id, edge_weight> edge_container;
+    typedef util::adjacency_store<vertex_id, edge_weight> edge_container;
+
+    bool rec_scc;
+    double q;
+    bool use_abs;
+    double slack = -1;
+    double flat = 0;
+    bool bucket_heap = false;   //  Set from the input by solve, see greedy_uses_bucket_heap
+
+    solver_hybrid(bool rec_scc_, double q_, bool use_abs_) : rec_scc(rec_scc_), q(q_), use_abs(use_abs_) {}
+
+    //  Shape of the recursion. A subproblem is a component with at least two vertices.
+    struct statistics {
+        vector<std::uint64_t> subproblems;      //  Subproblems at each depth
+        vector<std::uint64_t> vertices;         //  Vertices of the subproblems at each depth
+        vector<std::uint64_t> sizes;            //  Subproblems with [2^i, 2^(i+1)) vertices
+        std::uint64_t bisections = 0;
+        std::uint64_t flat_stops = 0;
+
+        void add(std::size_t depth, vertex_id size) {
+            if (subproblems.size() <= depth) {
+                subproblems.resize(depth + 1, 0);
+                vertices.resize(depth + 1, 0);
+            }
+            ++subproblems[depth];
+            vertices[depth] += size;
+            std::size_t b = 63 - __builtin_clzll((unsigned long long)size);
+            if (sizes.size() <= b) sizes.resize(b + 1, 0);
+            ++sizes[b];
+        }
+
+        void merge(const statistics& o) {
+            if (subproblems.size() < o.subproblems.size()) {
+                subproblems.resize(o.subproblems.size(), 0);
+                vertices.resize(o.vertices.size(), 0);
+            }
+            for (std::size_t d = 0; d < o.subproblems.size(); ++d) {
+                subproblems[d] += o.subproblems[d];
+                vertices[d] += o.vertices[d];
+            }
+            if (sizes.size() < o.sizes.size()) sizes.resize(o.sizes.size(), 0);
+            for (std::size_t b = 0; b < o.sizes.size(); ++b)
+                sizes[b] += o.sizes[b];
+            bisections += o.bisections;
+            flat_stops += o.flat_stops;
+        }
+    };
+    statistics stats;
 
     enum stat_t { normal = 0, inqueue = 1, deleted = 2 };
 
@@ -32,15 +89,13 @@ struct solver_hybrid {
 
     vector<vertex_id> s, id;
     typedef pair<typename vector<vertex_id>::iterator, typename vector<vertex_id>::iterator> pii;
-    list<pii> k;
     vector<list<vertex_id>> l;
 
-    vector<edge_container> g, h;
+    edge_container g, h;
     vector<edge_weight> gs, hs;
 
     typedef pair<vertex_id, edge_weight> pvw;
     typedef pair<edge_weight, vertex_id> pwv;
-    queue<vertex_id> q;
     vector<priority_queue<pwv>> gq, hq;
     vector<pwv> gc, hc;
     const pwv nil = { 0, 0 };
@@ -55,9 +110,35 @@ struct solver_hybrid {
         return h[u].size() == 1 ? pwv(h[u].begin()->second, h[u].begin()->first) : nil;
     }
 
-    void enqueue(vertex_id u) {
+    typedef util::static_histogram_max_heap<edge_weight, vertex_id> lheap;
+    typedef util::static_bucket_max_heap<edge_weight, vertex_id> bheap;
+
+    //  Scratch space of a worker. Components are processed concurrently, and each
+    //  of them only touches the per-vertex state of its own vertices.
+    struct context {
+        queue<vertex_id> q;
+        vertex_id color_num, dfc;
+        vector<vertex_id> stk;
+        vector<pair<vertex_id, typename edge_container::const_iterator>> ctx;
+        vector<pair<vertex_id, vertex_id>> par_es;
+
+        //  Greedy on a component, indexed by the local id of vertices
+        vector<char> del;
+        vector<edge_weight> iws, ows, vio, voi, psum;
+        vector<vertex_id> source, sink, rk, ord;
+        edge_weight mw;
+
+        statistics st;
+
+        //  Greedy uses bheap if bucket_heap is set, and lheap otherwise
+        lheap hio, hoi;
+        bheap bio, boi;
+    };
+    vector<context> cs;
+
+    void enqueue(context& c, vertex_id u) {
         if (stat[u] != normal) return;
-        q.push(u);
+        c.q.push(u);
         stat[u] = inqueue;
     }
 
@@ -84,9 +165,9 @@ struct solver_hybrid {
     }
 
     //  Find new contractible arcs
-    void checkq(vertex_id u) {
+    void checkq(context& c, vertex_id u) {
         if (checkg(u) || checkh(u))
-            enqueue(u);
+            enqueue(c, u);
         while (!gq[u].empty()) {
             pwv p = gq[u].top();
             vertex_id v = p.second;
@@ -95,7 +176,7 @@ struct solver_hybrid {
                 if (w < gs[u])
                     break;
                 else
-                    enqueue(v);
+                    enqueue(c, v);
             }
             gq[u].pop();
             gc[v] = nil;
@@ -108,7 +189,7 @@ struct solver_hybrid {
                 if (w < hs[u])
                     break;
                 else
-                    enqueue(v);
+                    enqueue(c, v);
             }
             hq[u].pop();
             hc[v] = nil;
@@ -160,7 +241,7 @@ struct solver_hybrid {
         }
     }
 
-    void contract(vertex_id u, vertex_id v) {
+    void contract(context& c, vertex_id u, vertex_id v) {
         del_edge(u, v);
 
         //  Merge vertex with smaller degree into vertex with larger degree
@@ -183,9 +264,9 @@ struct solver_hybrid {
         for (const pvw& e : gu) checkc(e.first);
         for (const pvw& e : hu) checkc(e.first);
         checkc(v);
-        for (const pvw& e : gu) checkq(e.first);
-        for (const pvw& e : hu) checkq(e.first);
-        checkq(v);
+        for (const pvw& e : gu) checkq(c, e.first);
+        for (const pvw& e : hu) checkq(c, e.first);
+        checkq(c, v);
         g[u].clear();
         h[u].clear();
         gq[u] = priority_queue<pwv>();
@@ -193,19 +274,19 @@ struct solver_hybrid {
         stat[u] = deleted;
     }
 
-    void reduction(pii& x) {
+    void reduction(context& c, pii& x) {
         for (auto it = x.first; it != x.second; ++it)
             checkc(*it);
         for (auto it = x.first; it != x.second; ++it)
-            checkq(*it);
-        while (!q.empty()) {
-            vertex_id u = q.front(); q.pop();
+            checkq(c, *it);
+        while (!c.q.empty()) {
+            vertex_id u = c.q.front(); c.q.pop();
             if (stat[u] == deleted) continue;
             stat[u] = normal;
             if (checkh(u))
-                contract(geth(u).second, u);
+                contract(c, geth(u).second, u);
             else if (checkg(u))
-                contract(u, getg(u).second);
+                contract(c, u, getg(u).second);
             else
                 checkc(u);
         }
@@ -213,13 +294,13 @@ struct solver_hybrid {
     }
 
 
-    vertex_id color_num, dfc;
-    vector<vertex_id> dfn, low, color, stk, inst;
-    vector<pair<vertex_id, typename edge_container::const_iterator>> ctx;
-    void scc_dfs(vertex_id x) {
+    vector<vertex_id> dfn, low, color, inst;
+    void scc_dfs(context& c, vertex_id x) {
+        auto& ctx = c.ctx;
+        auto& stk = c.stk;
         ctx.emplace_back(x, g[x].begin());
         stk.push_back(x); inst[x] = 1;
-        dfn[x] = low[x] = dfc++;
+        dfn[x] = low[x] = c.dfc++;
         while (!ctx.empty()) {
             vertex_id u = ctx.back().first;
             typename edge_container::const_iterator it = ctx.back().second, it_end = g[u].end();
@@ -232,7 +313,7 @@ struct solver_hybrid {
                     ctx.emplace_back(v, g[v].begin());
                     stk.push_back(v); inst[v] = 1;
                     // vis[v] = 1;
-                    dfn[v] = low[v] = dfc++;
+                    dfn[v] = low[v] = c.dfc++;
                 }
                 else if (inst[v])
                     low[u] = std::min(low[u], dfn[v]);
@@ -246,35 +327,35 @@ struct solver_hybrid {
                         v = stk.back();
                         stk.pop_back();
                         inst[v] = 0;
-                        color[v] = color_num;
+                        color[v] = c.color_num;
                     } while (v != u);
-                    ++color_num;
+                    ++c.color_num;
                 }
             }
         }
     }
 
-    void scc_decomp(const pii& x) {
-        color_num = dfc = 0;
+    void scc_decomp(context& c, const pii& x) {
+        c.color_num = c.dfc = 0;
         for (auto it = x.first; it != x.second; ++it)
             dfn[*it] = n;
         for (auto it = x.first; it != x.second; ++it)
             if (dfn[*it] == n)
-                scc_dfs(*it);
+                scc_dfs(c, *it);
         for (auto it = x.first; it != x.second; ++it)
-            color[*it] = color_num - color[*it] - 1;
+            color[*it] = c.color_num - color[*it] - 1;
     }
 
-    typedef util::static_histogram_max_heap<edge_weight, vertex_id> lheap;
-    
-    vector<char> del;
-    vector<edge_weight> iws, ows, vio, voi, psum;
-    vector<vertex_id> source, sink, rk;
-    edge_weight mw;
-
-    lheap hio, hoi;
-
-    void greedy_remove_vertex(const pii& x, vertex_id u) {
+    template<bool useAbs, class Heap>
+    void greedy_remove_vertex(context& c, const pii& x, vertex_id u, Heap& hio, Heap& hoi) {
+        auto& del = c.del;
+        auto& iws = c.iws;
+        auto& ows = c.ows;
+        auto& vio = c.vio;
+        auto& voi = c.voi;
+        auto& source = c.source;
+        auto& sink = c.sink;
+        auto& mw = c.mw;
         del[u] = 1;
         for (const auto& e : h[x.first[u]]) {
             vertex_id v = id[e.first];
@@ -304,34 +385,26 @@ struct solver_hybrid {
         }
     }
 
-    void greedy_decomp(const pii& x) {
-        color_num = 2;
+    //  Rank the vertices of x by Greedy into rk
+    template<bool useAbs, class Heap>
+    void greedy_rank(context& c, const pii& x, Heap& hio, Heap& hoi) {
+        auto& del = c.del;
+        auto& iws = c.iws;
+        auto& ows = c.ows;
+        auto& vio = c.vio;
+        auto& voi = c.voi;
+        auto& source = c.source;
+        auto& sink = c.sink;
+        auto& rk = c.rk;
+        auto& mw = c.mw;
         const vertex_id n2 = x.second - x.first;
-        for (vertex_id i = 0; i < n2; ++i)
-            id[x.first[i]] = i;
-        del.resize(n2); fill_n(del.begin(), n2, 0);
-        iws.resize(n2); fill_n(iws.begin(), n2, 0);
-        ows.resize(n2); fill_n(ows.begin(), n2, 0);
-        if constexpr (useAbs) { vio.resize(n2); fill_n(vio.begin(), n2, 0); }
-        voi.resize(n2, 0); fill_n(voi.begin(), n2, 0);
-        for (vertex_id i = 0; i < n2; ++i) {
-            vertex_id u = x.first[i];
-            iws[id[u]] = hs[u];
-            ows[id[u]] = gs[u];
-        }
-
-        mw = 0;
-        for (vertex_id i = 0; i < n2; ++i)
-            mw = max({ mw, iws[i], ows[i] });
-        for (vertex_id i = 0; i < n2; ++i) {
-            if constexpr (useAbs)
-                vio[i] =  mw + iws[i] - ows[i];
-            voi[i] = mw + ows[i] - iws[i];
-        }
         if constexpr (useAbs)
             hio.assign(2 * mw + 1, vio.begin(), vio.end());
         hoi.assign(2 * mw + 1, voi.begin(), voi.end());
 
+        //  The previous component may leave removed vertices behind
+        source.clear();
+        sink.clear();
         for (vertex_id i = 0; i < n2; ++i) {
             if (ows[i] == 0)
                 sink.push_back(i);
@@ -346,14 +419,14 @@ struct solver_hybrid {
                 vertex_id u = sink.back();
                 sink.pop_back();
                 if (del[u]) continue;
-                greedy_remove_vertex(x, u);
+                greedy_remove_vertex<useAbs>(c, x, u, hio, hoi);
                 rk[u] = --rp;
             }
             while (!source.empty()) {
                 vertex_id u = source.back();
                 source.pop_back();
                 if (del[u]) continue;
-                greedy_remove_vertex(x, u);
+                greedy_remove_vertex<useAbs>(c, x, u, hio, hoi);
                 rk[u] = lp++;
             }
             if (lp == rp) break;
@@ -363,13 +436,54 @@ struct solver_hybrid {
             while (del[ul = hoi.top()]) hoi.pop();
             if (!useAbs || voi[ul] > vio[ur]) {
                 rk[ul] = lp++;
-                greedy_remove_vertex(x, ul);
+                greedy_remove_vertex<useAbs>(c, x, ul, hio, hoi);
             }
             else {
                 rk[ur] = --rp;
-                greedy_remove_vertex(x, ur);
+                greedy_remove_vertex<useAbs>(c, x, ur, hio, hoi);
             }
         }
+    }
+
+    //  Bisect x by the ordering of Greedy. Returns true instead if the cut profile is flat,
+    //  with x reordered by Greedy.
+    template<bool useAbs>
+    bool greedy_decomp(context& c, const pii& x) {
+        auto& del = c.del;
+        auto& iws = c.iws;
+        auto& ows = c.ows;
+        auto& vio = c.vio;
+        auto& voi = c.voi;
+        auto& psum = c.psum;
+        auto& rk = c.rk;
+        auto& mw = c.mw;
+        c.color_num = 2;
+        const vertex_id n2 = x.second - x.first;
+        for (vertex_id i = 0; i < n2; ++i)
+            id[x.first[i]] = i;
+        del.resize(n2); fill_n(del.begin(), n2, 0);
+        iws.resize(n2); fill_n(iws.begin(), n2, 0);
+        ows.resize(n2); fill_n(ows.begin(), n2, 0);
+        if constexpr (useAbs) { vio.resize(n2); fill_n(vio.begin(), n2, 0); }
+        voi.resize(n2, 0); fill_n(voi.begin(), n2, 0);
+        for (vertex_id i = 0; i < n2; ++i) {
+            vertex_id u = x.first[i];
+            iws[id[u]] = hs[u];
+            ows[id[u]] = gs[u];
+        }
+
+        mw = 0;
+        for (vertex_id i = 0; i < n2; ++i)
+            mw = max({ mw, iws[i], ows[i] });
+        for (vertex_id i = 0; i < n2; ++i) {
+            if constexpr (useAbs)
+                vio[i] =  mw + iws[i] - ows[i];
+            voi[i] = mw + ows[i] - iws[i];
+        }
+        if (bucket_heap)
+            greedy_rank<useAbs>(c, x, c.bio, c.boi);
+        else
+            greedy_rank<useAbs>(c, x, c.hio, c.hoi);
 
         psum.resize(n2 + 1, 0);
         fill_n(psum.begin(), n2 + 1, 0);
@@ -383,29 +497,48 @@ struct solver_hybrid {
         }
         
         vertex_id pos = n2;
-        edge_weight pos_w = -1;
+        edge_weight pos_w = -1, lo_w = -1, hi_w = 0;
         for (vertex_id i = 0; i + 1 < n2; ++i) {
             psum[i + 1] += psum[i];
-            if (P == -1 || min(i + 1, n2 - i - 1) * P >= n2) {
+            if (lo_w == -1 || psum[i] < lo_w) lo_w = psum[i];
+            hi_w = max(hi_w, psum[i]);
+            if (q <= 0 || min(i + 1, n2 - i - 1) * q >= n2) {
                 if (pos == n2 || psum[i] < pos_w) {
                     pos = i;
                     pos_w = psum[i];
                 }
             }
         }
+        if (flat > 0 && n2 > 2 && hi_w - lo_w <= flat * hi_w) {
+            auto& ord = c.ord;
+            ord.resize(n2);
+            for (vertex_id i = 0; i < n2; ++i)
+                ord[rk[i]] = x.first[i];
+            copy(ord.begin(), ord.end(), x.first);
+            return true;
+        }
+        if (slack >= 0 && pos != n2) {
+            //  Most balanced cut within the slack of the minimum
+            const double lim = (1 + slack) * pos_w;
+            for (vertex_id i = 0; i + 1 < n2; ++i)
+                if ((q <= 0 || min(i + 1, n2 - i - 1) * q >= n2) && psum[i] <= lim
+                    && min(i + 1, n2 - i - 1) > min(pos + 1, n2 - pos - 1))
+                    pos = i;
+        }
         if (pos == n2 || pos_w == -1)
             pos = n2 / 2;
 
         for (vertex_id i = 0; i < n2; ++i)
             color[x.first[i]] = (rk[i] > pos ? 1 : 0);
+        return false;
     }
 
-    vector<pair<vertex_id, vertex_id>> par_es;
-    vector<pii> partition(const pii& x) {
+    vector<pii> partition(context& c, const pii& x) {
+        auto& par_es = c.par_es;
         // vertex_id n2 = x.second - x.first;
         sort(x.first, x.second, [&](vertex_id u, vertex_id v) { return color[u] < color[v]; });
         vector<pii> res;
-        res.reserve(color_num);
+        res.reserve(c.color_num);
         
         for (auto it = x.first; it != x.second; ++it) {
             vertex_id u = *it;
@@ -423,10 +556,100 @@ struct solver_hybrid {
         for (auto e : par_es)
             del_edge(e.first, e.second);
         par_es.clear();
+        //  Drop the contraction candidates, which may refer to vertices of the other parts.
+        //  reduction() finds them again from the remaining arcs.
+        if (res.size() > 1)
+            for (auto it = x.first; it != x.second; ++it) {
+                vertex_id u = *it;
+                gq[u] = priority_queue<pwv>();
+                hq[u] = priority_queue<pwv>();
+                gc[u] = hc[u] = nil;
+            }
         return res;
     }
 
+    //  Number of vertices of the input graph contracted into the vertices of x
+    vertex_id original_size(const pii& x) {
+        vertex_id r = 0;
+        for (auto it = x.first; it != x.second; ++it)
+            r += l[*it].size();
+        return r;
+    }
+
+    //  Components with fewer vertices are processed by the task that split them off
+    static constexpr vertex_id spawn_size = 256;
+
+    //  Solve component x at recursion depth d, whose vertices take positions from p on in res
+    void process(util::task_group& tg, pii x, vertex_id p, std::size_t d, solution<Graph>& res) {
+        if (x.second == x.first + 1) {
+            for (vertex_id v : l[x.first[0]])
+                res[v] = p++;
+            return;
+        }
+        context& c = cs[util::work_stealing_pool::worker_index()];
+        c.st.add(d, x.second - x.first);
+        {
+            util::profile::scope prof("reduction");
+            reduction(c, x);
+        }
+        {
+            util::profile::scope prof("scc");
+            scc_decomp(c, x);
+        }
+        vector<pii> scc_res;
+        {
+            util::profile::scope prof("partition");
+            scc_res = partition(c, x);
+        }
+        vector<pair<pii, bool>> sub;    //  Parts, and whether they are already ordered
+        if (rec_scc && c.color_num > 1) {
+            for (pii& y : scc_res)
+                sub.emplace_back(y, false);
+        }
+        else {
+            for (pii& y : scc_res) {
+                if (y.second - y.first > 1) {
+                    bool done;
+                    {
+                        util::profile::scope prof("greedy");
+                        done = use_abs ? greedy_decomp<true>(c, y) : greedy_decomp<false>(c, y);
+                    }
+                    if (done) {
+                        ++c.st.flat_stops;
+                        sub.emplace_back(y, true);
+                        continue;
+                    }
+                    ++c.st.bisections;
+                    util::profile::scope prof("partition");
+                    vector<pii> bisect_res = partition(c, y);
+                    sub.emplace_back(bisect_res[0], false);
+                    sub.emplace_back(bisect_res[1], false);
+                }
+                else 
+                    sub.emplace_back(y, false);
+            }
+        }
+        for (const auto& [y, done] : sub) {
+            vertex_id py = p;
+            p += original_size(y);
+            if (done) {
+                for (auto it = y.first; it != y.second; ++it)
+                    for (vertex_id v : l[*it])
+                        res[v] = py++;
+            }
+            else if (y.second - y.first < spawn_size)
+                process(tg, y, py, d + 1, res);
+            else
+                tg.spawn([this, &tg, &res, y = y, py, d]() { process(tg, y, py, d + 1, res); });
+        }
+    }
+
+    //  Components are processed as tasks of a work-stealing pool with util::num_threads() workers,
+    //  or of the pool of the caller if it is a worker. The result does not depend on the number of workers.
     solution<Graph> solve(const Graph& g0) {
+        util::profile::scope prof("hybrid");
+        stats = statistics();
+        bucket_heap = greedy_uses_bucket_heap(g0);
         n = g0.num_vertices();
         id.resize(n, n);
         g.resize(n);
@@ -444,19 +667,8 @@ struct solver_hybrid {
         inst.resize(n, 0);
         color.resize(n, n);
 
-        del.reserve(n);
-        source.reserve(n);
-        sink.reserve(n);
-        iws.reserve(n);
-        ows.reserve(n);
-        if constexpr (useAbs) vio.reserve(n);
-        voi.reserve(n);
-        rk.resize(n, n);
-        psum.reserve(n);
-
         s.assign(n, 0);
         iota(s.begin(), s.end(), 0);
-        k.emplace_back(s.begin(), s.end());
 
         l.resize(n);
         for (vertex_id u = 0; u < n; ++u)
@@ -465,48 +677,22 @@ struct solver_hybrid {
         for (const auto& e : g0.edges())
             add_edge(e.src, e.dst, e.weight);
             
-        vertex_id p = 0;
         solution<Graph> res(n);
-        auto it = k.begin();
-        while (it != k.end()) {        
-            if (it->second == it->first + 1) {
-                for (vertex_id v : l[it->first[0]])
-                    res[v] = p++;
-                ++it;
-            }
-            else {
-                pii x = *it;
-                reduction(x);
-                scc_decomp(x);
-                vector<pii> scc_res = partition(x);
-                auto it2 = next(it);
-                if (RecSCC && color_num > 1) {
-                    for (const pii& y : scc_res)
-                        k.emplace(it2, y);
-                }
-                else {
-                    for (pii& y : scc_res) {
-                        if (y.second - y.first > 1) {
-                            greedy_decomp(y);
-                            vector<pii> bisect_res = partition(y);
-                            k.emplace(it2, bisect_res[0]);
-                            k.emplace(it2, bisect_res[1]);
-                        }
-                        else 
-                            k.emplace(it2, y);
-                    }
-                }
-                it = k.erase(it);
-            }
-        }
-
+        if (n == 0) return res;
+        util::pool_ref pool;
+        cs.resize(pool->num_workers());
+        util::task_group tg(*pool);
+        process(tg, pii(s.begin(), s.end()), 0, 0, res);
+        tg.sync();
+        for (const context& c : cs)
+            stats.merge(c.st);
         return res;
     }
 };
 
-template<class Graph, bool RecSCC, int P, bool useAbs>
-solution<Graph> hybrid(const Graph& g) {
-    return solver_hybrid<Graph, RecSCC, P, useAbs>().solve(g);
+template<class Graph>
+solution<Graph> hybrid(const Graph& g, bool rec_scc, double q, bool use_abs) {
+    return solver_hybrid<Graph>(rec_scc, q, use_abs).solve(g);
 }
 
 }
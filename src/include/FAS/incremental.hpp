@@ -0,0 +1,271 @@
+#ifndef FAS_INCREMENTAL_HPP
+#define FAS_INCREMENTAL_HPP
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <graph/dynamic.hpp>
+#include <FAS/common.hpp>
+#include <FAS/greedy.hpp>
+
+namespace FAS {
+
+//  Incremental FAS: keeps an ordering of a graph that changes by batches of arc insertions
+//  and deletions, without solving it again after every batch.
+//  A deleted arc can only make the FAS lighter, and an inserted arc (u, v) is backward iff
+//  rk[u] >= rk[v], in which case only the positions [rk[v], rk[u]] are repaired. Overlapping
+//  ranges are merged. A range of at most max_window positions is a window: its vertices are
+//  reordered by the local solver on the subgraph they induce, which leaves the arcs to and from
+//  the rest of the ordering as they were, and then each of them is moved to its best position
+//  inside the window. In longer ranges, only the endpoints of the new backward arcs are moved,
+//  to their best positions in the whole ordering.
+//  Repairs only keep changes that make the FAS lighter. The share of the total arc weight that
+//  is backward is compared with the share after the last full solve, and the graph is solved
+//  from scratch by the full solver once it exceeds it by more than a factor of 1 + drift.
+//  A share below min_share counts as min_share, so that a graph that was acyclic at the last
+//  full solve is not solved again as soon as a single arc stays backward.
+//  Graph is the type of the snapshots given to the solvers.
+template<class Graph>
+class incremental_fas {
+public:
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_id_t<Graph> edge_id;
+    typedef edge_weight_t<Graph> edge_weight;
+    typedef edge_t<Graph> edge_type;
+
+    typedef dynamic_graph<vertex_id, edge_id, edge_weight> dynamic_type;
+
+    struct statistics {
+        std::uint64_t batches = 0;
+        std::uint64_t inserted = 0;
+        std::uint64_t deleted = 0;
+        std::uint64_t backward = 0;         //  Inserted arcs that were backward
+        std::uint64_t windows = 0;
+        std::uint64_t window_vertices = 0;
+        std::uint64_t sifted = 0;           //  Endpoints of long backward arcs
+        std::uint64_t full_solves = 0;
+    };
+
+    solver<Graph> full, local;
+    double drift;
+    vertex_id max_window = 4096;
+    double min_share = 0.001;
+    statistics stats;
+
+private:
+    dynamic_type g;
+    solution<Graph> rk;
+    vector<vertex_id> ord;
+    edge_weight w = 0, wsum = 0;        //  Backward and total weight of the arcs
+    double share_full = 0;
+    vector<vertex_id> local_id;         //  Position in the window being repaired, or -1
+
+    //  Neighbor at position p, with the weight of the arc to it (w > 0) or from it (w < 0)
+    struct neighbor {
+        vertex_id p;
+        edge_weight w;
+        bool operator<(const neighbor& o) const { return p < o.p; }
+    };
+    vector<neighbor> nb;
+
+    double share() const { return wsum > 0 ? double(w) / wsum : 0; }
+
+    void set_ordering(solution<Graph> rk_) {
+        rk = std::move(rk_);
+        ord = inv<Graph>(rk);
+        w = wsum = 0;
+        for (const edge_type& e : g.edges()) {
+            wsum += e.weight;
+            if (rk[e.src] >= rk[e.dst])
+                w += e.weight;
+        }
+    }
+
+    //  Move v to the position in [lo, hi] where the fewest of its arcs to vertices in [lo, hi]
+    //  are backward, which are the only ones that can change. Returns the gain.
+    edge_weight sift(vertex_id v, vertex_id lo, vertex_id hi) {
+        nb.clear();
+        edge_weight cost = 0, cur = 0;
+        for (const edge_type& e : g.out_edges(v))
+            if (e.dst != v && lo <= rk[e.dst] && rk[e.dst] <= hi) {
+                nb.push_back({ rk[e.dst], e.weight });
+                if (rk[e.dst] < rk[v])
+                    cur += e.weight;
+            }
+        for (const edge_type& e : g.in_edges(v))
+            if (e.src != v && lo <= rk[e.src] && rk[e.src] <= hi) {
+                nb.push_back({ rk[e.src], -e.weight });
+                cost += e.weight;       //  Placed first, every arc from a neighbor is backward
+                if (rk[e.src] > rk[v])
+                    cur += e.weight;
+            }
+        if (nb.empty()) return 0;
+        std::sort(nb.begin(), nb.end());
+        //  Gap i lies between nb[i - 1] and nb[i]
+        const std::size_t d = nb.size();
+        std::size_t best = d + 1;
+        edge_weight best_cost = cur;
+        for (std::size_t i = 0; i <= d; ++i) {
+            if (i > 0) cost += nb[i - 1].w;
+            if (cost >= best_cost) continue;
+            if (i > 0 && i < d && nb[i - 1].p == nb[i].p) continue;
+            best = i;
+            best_cost = cost;
+        }
+        if (best == d + 1) return 0;
+        //  Right after nb[best - 1], or right before nb[0]
+        const vertex_id a = rk[v];
+        vertex_id p;
+        if (best > 0)
+            p = nb[best - 1].p < a ? nb[best - 1].p + 1 : nb[best - 1].p;
+        else
+            p = nb[0].p < a ? nb[0].p : nb[0].p - 1;
+        if (p < a)
+            std::rotate(ord.begin() + p, ord.begin() + a, ord.begin() + a + 1);
+        else
+            std::rotate(ord.begin() + a, ord.begin() + a + 1, ord.begin() + p + 1);
+        for (vertex_id i = min(a, p); i <= max(a, p); ++i)
+            rk[ord[i]] = i;
+        return cur - best_cost;
+    }
+
+    void repair_window(vertex_id l, vertex_id r) {
+        const vertex_id k = r - l + 1;
+        for (vertex_id i = 0; i < k; ++i)
+            local_id[ord[l + i]] = i;
+        vector<edge_type> es;
+        edge_weight before = 0;
+        for (vertex_id i = 0; i < k; ++i)
+            for (const edge_type& e : g.out_edges(ord[l + i])) {
+                const vertex_id j = local_id[e.dst];
+                if (j == -1) continue;
+                es.emplace_back(i, j, e.weight);
+                if (i >= j) before += e.weight;
+            }
+        for (vertex_id i = 0; i < k; ++i)
+            local_id[ord[l + i]] = -1;
+        const Graph s(k, es.begin(), es.end());
+        const solution<Graph> x = local(s);
+        const edge_weight after = get_fas_weight(s, x);
+        if (after >= 0 && after < before) {
+            const vector<vertex_id> vs(ord.begin() + l, ord.begin() + r + 1);
+            for (vertex_id i = 0; i < k; ++i) {
+                ord[l + x[i]] = vs[i];
+                rk[vs[i]] = l + x[i];
+            }
+            w -= before - after;
+        }
+        const vector<vertex_id> vs(ord.begin() + l, ord.begin() + r + 1);
+        for (vertex_id v : vs)
+            w -= sift(v, l, r);
+        ++stats.windows;
+        stats.window_vertices += k;
+    }
+
+public:
+    //  Starts from the ordering rk0 of g0, or from a full solve if rk0 is empty
+    incremental_fas(const Graph& g0, solver<Graph> full_, double drift_ = 0.1,
+        const solution<Graph>& rk0 = {}, solver<Graph> local_ = greedy<Graph>)
+        : full(std::move(full_)), local(std::move(local_)), drift(drift_), g(g0.num_vertices()) {
+        vector<edge_type> es;
+        es.reserve(g0.num_edges());
+        for (const edge_type& e : g0.edges())
+            es.push_back(e);
+        g.insert_edges(es.begin(), es.end());
+        local_id.assign(g.num_vertices(), -1);
+        if (rk0.empty())
+            resolve();
+        else {
+            set_ordering(rk0);
+            share_full = share();
+        }
+    }
+
+    const dynamic_type& get_graph() const { return g; }
+
+    const solution<Graph>& ordering() const { return rk; }
+
+    //  Weight of the backward arcs of ordering()
+    edge_weight fas_weight() const { return w; }
+
+    //  Static copy of the current graph
+    Graph snapshot() const {
+        vector<edge_type> es;
+        es.reserve(g.num_edges());
+        for (const edge_type& e : g.edges())
+            es.push_back(e);
+        return Graph(g.num_vertices(), es.begin(), es.end());
+    }
+
+    void resolve() {
+        set_ordering(full(snapshot()));
+        share_full = share();
+        ++stats.full_solves;
+    }
+
+    //  Delete the arcs of del, then insert those of ins, whose endpoints may be new vertices.
+    //  New vertices are placed at the end of the ordering.
+    void apply(const vector<edge_type>& ins, const vector<edge_type>& del) {
+        ++stats.batches;
+        vertex_id n = g.num_vertices();
+        for (const edge_type& e : del) {
+            if (e.src >= n || e.dst >= n || !g.has_edge(e.src, e.dst)) continue;
+            const edge_weight x = g.erase_edge(e.src, e.dst);
+            wsum -= x;
+            if (rk[e.src] >= rk[e.dst])
+                w -= x;
+            ++stats.deleted;
+        }
+        vertex_id m = n;
+        for (const edge_type& e : ins)
+            m = max(m, max(e.src, e.dst) + 1);
+        if (m > n) {
+            g.add_vertices(m - n);
+            local_id.resize(m, -1);
+            for (vertex_id v = n; v < m; ++v) {
+                rk.push_back(v);
+                ord.push_back(v);
+            }
+            n = m;
+        }
+        //  Ranges of the new backward arcs, with their endpoints
+        vector<std::pair<std::pair<vertex_id, vertex_id>, std::pair<vertex_id, vertex_id>>> iv;
+        for (const edge_type& e : ins) {
+            g.insert_edge(e.src, e.dst, e.weight);
+            wsum += e.weight;
+            ++stats.inserted;
+            if (rk[e.src] < rk[e.dst]) continue;
+            w += e.weight;
+            ++stats.backward;
+            if (e.src != e.dst)
+                iv.push_back({ { rk[e.dst], rk[e.src] }, { e.dst, e.src } });
+        }
+        std::sort(iv.begin(), iv.end());
+        //  Windows only permute their own positions, so the ranges stay valid until the
+        //  endpoints of the long ones are moved at the end
+        vector<vertex_id> far;
+        for (std::size_t i = 0, j; i < iv.size(); i = j) {
+            vertex_id l = iv[i].first.first, r = iv[i].first.second;
+            for (j = i + 1; j < iv.size() && iv[j].first.first <= r; ++j)
+                r = max(r, iv[j].first.second);
+            if (r - l + 1 <= max_window)
+                repair_window(l, r);
+            else
+                for (std::size_t t = i; t < j; ++t) {
+                    far.push_back(iv[t].second.first);
+                    far.push_back(iv[t].second.second);
+                }
+        }
+        std::sort(far.begin(), far.end());
+        far.erase(std::unique(far.begin(), far.end()), far.end());
+        for (vertex_id v : far)
+            w -= sift(v, 0, n - 1);
+        stats.sifted += far.size();
+        if (w > 0 && share() > (1 + drift) * std::max(share_full, min_share))
+            resolve();
+    }
+};
+
+}
+
+#endif
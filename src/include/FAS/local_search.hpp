@@ -0,0 +1,201 @@
+#ifndef FAS_LOCAL_SEARCH_HPP
+#define FAS_LOCAL_SEARCH_HPP
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include <util/work_stealing.hpp>
+#include <FAS/common.hpp>
+
+namespace FAS {
+
+//  Sifting: repeatedly move a single vertex to the position of the ordering with the least
+//  weight of backward arcs. Only the order of v relative to its neighbors matters for the arcs
+//  of v, so the best position is found by sorting the neighbors of v and sweeping over them,
+//  in O(d log d) for a vertex of degree d.
+//  Vertices are grouped into independent sets by a greedy coloring of the underlying
+//  undirected graph. The vertices of a set are moved at the same time, by different threads;
+//  as no two of them are adjacent, the gains add up and the result does not depend on the
+//  number of threads. Positions are kept as keys, and a moved vertex takes a key between those
+//  of the two neighbors it is placed between, so a move costs no more than computing it.
+//  A pass moves every set once. Passes are repeated until one of them gains nothing, or
+//  until max_passes passes or time_limit seconds, if positive, are used up.
+//  The time limit is only checked between sets, and makes the result depend on timing.
+//  Called from a worker of a work_stealing_pool, the moves run on that pool.
+template<class Graph>
+struct improver_sifting {
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_id_t<Graph> edge_id;
+    typedef edge_weight_t<Graph> edge_weight;
+
+    static constexpr vertex_id grain = 256;
+
+    double time_limit;
+    unsigned max_passes;
+
+    explicit improver_sifting(double time_limit_ = 0, unsigned max_passes_ = 0)
+        : time_limit(time_limit_), max_passes(max_passes_) {}
+
+    //  Neighbor u of a vertex, with the weight of the arc to u (w > 0) or from u (w < 0)
+    struct arc {
+        vertex_id u;
+        edge_weight w;
+    };
+
+    struct neighbor {
+        double key;
+        vertex_id u;
+        edge_weight w;
+        bool operator<(const neighbor& o) const { return key < o.key || (key == o.key && u < o.u); }
+    };
+
+    vertex_id n;
+    vector<edge_id> off;
+    vector<arc> adj;
+    vector<double> key;
+    vector<vector<neighbor>> scratch;   //  Per worker
+
+    //  Undirected adjacency lists, with self-loops left out since they are always backward
+    void build(const Graph& g) {
+        off.assign(n + 1, 0);
+        for (const auto& e : g.edges())
+            if (e.src != e.dst) {
+                ++off[e.src + 1];
+                ++off[e.dst + 1];
+            }
+        for (vertex_id u = 0; u < n; ++u)
+            off[u + 1] += off[u];
+        adj.resize(off[n]);
+        vector<edge_id> p(off.begin(), off.end() - 1);
+        for (const auto& e : g.edges())
+            if (e.src != e.dst) {
+                adj[p[e.src]++] = { e.dst, e.weight };
+                adj[p[e.dst]++] = { e.src, -e.weight };
+            }
+    }
+
+    //  Independent sets of a greedy coloring, taking vertices by decreasing degree
+    vector<vector<vertex_id>> independent_sets() const {
+        vector<vertex_id> ord(n);
+        std::iota(ord.begin(), ord.end(), 0);
+        std::stable_sort(ord.begin(), ord.end(), [&](vertex_id a, vertex_id b) {
+            return off[a + 1] - off[a] > off[b + 1] - off[b];
+        });
+        vector<vertex_id> color(n, -1), mark;
+        vector<vector<vertex_id>> res;
+        for (vertex_id v : ord) {
+            for (edge_id i = off[v]; i < off[v + 1]; ++i) {
+                vertex_id c = color[adj[i].u];
+                if (c != -1) {
+                    if ((vertex_id)mark.size() <= c) mark.resize(c + 1, -1);
+                    mark[c] = v;
+                }
+            }
+            vertex_id c = 0;
+            while (c < (vertex_id)mark.size() && mark[c] == v) ++c;
+            if (c == (vertex_id)res.size()) res.emplace_back();
+            color[v] = c;
+            res[c].push_back(v);
+        }
+        for (auto& s : res)
+            std::sort(s.begin(), s.end());
+        return res;
+    }
+
+    //  Move v to its best position, returns the gain
+    edge_weight move(vertex_id v, vector<neighbor>& nb) {
+        nb.clear();
+        edge_weight cost = 0, cur = 0;
+        for (edge_id i = off[v]; i < off[v + 1]; ++i) {
+            const arc& a = adj[i];
+            nb.push_back({ key[a.u], a.u, a.w });
+            if (a.w < 0)
+                cost -= a.w;        //  Placed first, every arc from a neighbor is backward
+            if (a.w > 0 ? key[a.u] < key[v] : key[a.u] > key[v])
+                cur += a.w > 0 ? a.w : -a.w;
+        }
+        if (nb.empty()) return 0;
+        std::sort(nb.begin(), nb.end());
+        //  Gap i lies between nb[i - 1] and nb[i]
+        const std::size_t d = nb.size();
+        std::size_t best = d + 1;
+        edge_weight best_cost = cur;
+        for (std::size_t i = 0; i <= d; ++i) {
+            if (i > 0) cost += nb[i - 1].w;
+            if (cost >= best_cost) continue;
+            if (i > 0 && i < d && !(nb[i - 1].key < nb[i].key)) continue;
+            best = i;
+            best_cost = cost;
+        }
+        if (best == d + 1) return 0;
+        double k;
+        if (best == 0)
+            k = nb[0].key - 1;
+        else if (best == d)
+            k = nb[d - 1].key + 1;
+        else {
+            k = nb[best - 1].key + (nb[best].key - nb[best - 1].key) / 2;
+            if (!(nb[best - 1].key < k && k < nb[best].key)) return 0;
+        }
+        key[v] = k;
+        return cur - best_cost;
+    }
+
+    solution<Graph> operator()(const Graph& g, const solution<Graph>& rk) {
+        n = g.num_vertices();
+        if (n <= 1) return rk;
+        const auto t0 = std::chrono::steady_clock::now();
+        auto expired = [&]() {
+            return time_limit > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() >= time_limit;
+        };
+        build(g);
+        const vector<vector<vertex_id>> sets = independent_sets();
+        key.resize(n);
+        for (vertex_id v = 0; v < n; ++v)
+            key[v] = rk[v];
+
+        util::pool_ref pool;
+        scratch.assign(pool->num_workers(), {});
+        vector<vertex_id> ord(n);
+        std::iota(ord.begin(), ord.end(), 0);
+        bool stop = false;
+        for (unsigned pass = 0; !stop && (max_passes == 0 || pass < max_passes); ++pass) {
+            edge_weight gain = 0;
+            for (const auto& s : sets) {
+                if (expired()) {
+                    stop = true;
+                    break;
+                }
+                vector<edge_weight> gs(pool->num_workers(), 0);
+                pool->parallel_for<std::size_t>(0, s.size(), grain, [&](std::size_t l, std::size_t r) {
+                    unsigned i = util::work_stealing_pool::worker_index();
+                    for (std::size_t j = l; j < r; ++j)
+                        gs[i] += move(s[j], scratch[i]);
+                });
+                for (edge_weight x : gs)
+                    gain += x;
+            }
+            //  Renumber the keys, so that gaps do not run out of precision
+            std::sort(ord.begin(), ord.end(), [&](vertex_id a, vertex_id b) {
+                return key[a] < key[b] || (key[a] == key[b] && a < b);
+            });
+            for (vertex_id i = 0; i < n; ++i)
+                key[ord[i]] = i;
+            if (gain == 0) break;
+        }
+        solution<Graph> res(n);
+        for (vertex_id i = 0; i < n; ++i)
+            res[ord[i]] = i;
+        return res;
+    }
+};
+
+template<class Graph>
+solution<Graph> sifting(const Graph& g, const solution<Graph>& rk, double time_limit = 0) {
+    return improver_sifting<Graph>(time_limit)(g, rk);
+}
+
+}
+
+#endif
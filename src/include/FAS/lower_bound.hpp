@@ -0,0 +1,143 @@
+#ifndef FAS_LOWER_BOUND_HPP
+#define FAS_LOWER_BOUND_HPP
+#include <atomic>
+#include <numeric>
+#include <vector>
+#include <FAS/common.hpp>
+#include <FAS/reduction.hpp>
+
+namespace FAS {
+
+//  Lower bound on the minimum FAS of a graph by a greedy fractional packing of cycles: every
+//  cycle found takes the least residual weight of its arcs from all of them, and the bound is
+//  the total weight taken. Each FAS contains an arc of every cycle, so it weighs at least that.
+//  With unit weights the cycles are arc-disjoint.
+//  Short cycles are packed first: in round L = 2, 4, ..., max_len, each vertex s repeatedly
+//  looks for a shortest cycle of length at most L through s by a BFS along arcs with residual
+//  weight. A search gives up after scanning budget arcs, and s is then skipped in the later
+//  rounds. The time is about budget times the number of vertices, and a larger budget gives a
+//  better bound.
+template<class Graph>
+struct cycle_packing {
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_id_t<Graph> edge_id;
+    typedef edge_weight_t<Graph> edge_weight;
+
+    vertex_id max_len;
+    edge_id budget;
+
+    explicit cycle_packing(vertex_id max_len_ = 16, edge_id budget_ = 512) : max_len(max_len_), budget(budget_) {}
+
+    edge_weight operator()(const Graph& g) const {
+        const vertex_id n = g.num_vertices();
+        vector<edge_id> off(n + 1, 0);
+        vector<vertex_id> src, dst;
+        vector<edge_weight> res;
+        vector<edge_id> din(n, 0), dout(n, 0);     //  Arcs with residual weight
+        edge_weight lb = 0;
+        for (vertex_id u = 0; u < n; ++u) {
+            for (const auto& e : g.out_edges(u)) {
+                if (e.dst == u)
+                    lb += e.weight;     //  Self-loops are in every FAS
+                else if (e.weight > 0) {
+                    src.push_back(u);
+                    dst.push_back(e.dst);
+                    res.push_back(e.weight);
+                    ++dout[u];
+                    ++din[e.dst];
+                }
+            }
+            off[u + 1] = dst.size();
+        }
+        //  Vertices on no cycle of residual arcs, and vertices whose search ran out of budget,
+        //  which would do so again in the later rounds
+        vector<char> dead(n, 0), capped(n, 0);
+
+        vector<vertex_id> seen(n, n), dist(n), par(n);
+        vector<edge_id> par_arc(n);
+        vector<vertex_id> q;
+        vector<edge_id> cyc;
+        //  Arc closing a cycle through s of length at most len, with the tree arcs in par_arc
+        //  If the search ends without reaching a limit, s is dead
+        auto find = [&](vertex_id s, vertex_id len) -> edge_id {
+            q.assign(1, s);
+            seen[s] = s;
+            dist[s] = 0;
+            edge_id scanned = 0;
+            for (std::size_t h = 0; h < q.size(); ++h) {
+                vertex_id u = q[h];
+                if (dist[u] + 1 > len) return -1;
+                for (edge_id a = off[u]; a < off[u + 1]; ++a) {
+                    if (res[a] == 0) continue;
+                    if (++scanned > budget) {
+                        capped[s] = 1;
+                        return -1;
+                    }
+                    vertex_id v = dst[a];
+                    if (v == s) {
+                        par[s] = u;
+                        return a;
+                    }
+                    if (seen[v] != s && !dead[v]) {
+                        seen[v] = s;
+                        dist[v] = dist[u] + 1;
+                        par[v] = u;
+                        par_arc[v] = a;
+                        q.push_back(v);
+                    }
+                }
+            }
+            dead[s] = 1;
+            return -1;
+        };
+
+        for (vertex_id len = 2; len <= max_len; len = (len < max_len ? min(2 * len, max_len) : len + 1))
+            for (vertex_id s = 0; s < n; ++s) {
+                while (!dead[s] && !capped[s]) {
+                    if (din[s] == 0 || dout[s] == 0) {
+                        dead[s] = 1;
+                        break;
+                    }
+                    edge_id a = find(s, len);
+                    if (a == (edge_id)-1) break;
+                    cyc.assign(1, a);
+                    for (vertex_id v = par[s]; v != s; v = par[v])
+                        cyc.push_back(par_arc[v]);
+                    edge_weight w = res[a];
+                    for (edge_id b : cyc)
+                        w = min(w, res[b]);
+                    for (edge_id b : cyc)
+                        if ((res[b] -= w) == 0) {
+                            --dout[src[b]];
+                            --din[dst[b]];
+                        }
+                    lb += w;
+                    //  Clear the marks for the next search from s
+                    for (vertex_id v : q)
+                        seen[v] = n;
+                }
+                for (vertex_id v : q)
+                    seen[v] = n;
+            }
+        return lb;
+    }
+};
+
+//  Lower bound on the minimum FAS of g: the weight paid by the reduction of fastred, plus
+//  cycle packings of the components it leaves, which are packed by different threads
+template<class Graph>
+edge_weight_t<Graph> fas_lower_bound(const Graph& g, cycle_packing<Graph> cp = cycle_packing<Graph>()) {
+    std::atomic<edge_weight_t<Graph>> lb{ 0 };
+    fastred<Graph, true> red;
+    red.solve(g, [&](const Graph& x) {
+        lb += cp(x);
+        solution<Graph> rk(x.num_vertices());
+        std::iota(rk.begin(), rk.end(), 0);
+        return rk;
+    });
+    return red.forced_weight() + lb.load();
+}
+
+}
+
+#endif
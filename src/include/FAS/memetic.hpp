@@ -0,0 +1,190 @@
+#ifndef FAS_MEMETIC_HPP
+#define FAS_MEMETIC_HPP
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <util/work_stealing.hpp>
+#include <FAS/common.hpp>
+#include <FAS/local_search.hpp>
+
+namespace FAS {
+
+//  Order crossover: the block [l, r) of positions of a is kept, the other vertices fill the
+//  remaining positions in the order of b
+template<class Graph>
+struct crossover_order {
+    typedef vertex_id_t<Graph> vertex_id;
+
+    std::uint64_t seed;
+    explicit crossover_order(std::uint64_t seed_) : seed(seed_) {}
+
+    solution<Graph> operator()(const Graph& g, const solution<Graph>& a, const solution<Graph>& b) const {
+        const vertex_id n = g.num_vertices();
+        std::mt19937_64 rng(seed);
+        vertex_id l = std::uniform_int_distribution<vertex_id>(0, n - 1)(rng);
+        vertex_id r = std::uniform_int_distribution<vertex_id>(0, n - 1)(rng);
+        if (l > r) swap(l, r);
+        ++r;
+        const solution<Graph> ob = inv<Graph>(b);
+        solution<Graph> c(n);
+        vertex_id p = 0;
+        for (vertex_id i = 0; i < n; ++i) {
+            vertex_id v = ob[i];
+            if (l <= a[v] && a[v] < r)
+                c[v] = a[v];
+            else {
+                if (p == l) p = r;
+                c[v] = p++;
+            }
+        }
+        return c;
+    }
+};
+
+//  Move k random vertices to random positions
+template<class Graph>
+struct perturber_insertion {
+    typedef vertex_id_t<Graph> vertex_id;
+
+    std::uint64_t seed;
+    vertex_id k;
+    perturber_insertion(std::uint64_t seed_, vertex_id k_) : seed(seed_), k(k_) {}
+
+    solution<Graph> operator()(const Graph& g, const solution<Graph>& a) const {
+        const vertex_id n = g.num_vertices();
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<vertex_id> uid(0, n - 1);
+        //  Positions scaled by two, with the moved vertices in between
+        vector<std::pair<long long, vertex_id>> key(n);
+        for (vertex_id v = 0; v < n; ++v)
+            key[v] = { 2ll * a[v], v };
+        for (vertex_id i = 0; i < k; ++i)
+            key[uid(rng)].first = 2ll * uid(rng) + 1;
+        std::sort(key.begin(), key.end());
+        solution<Graph> c(n);
+        for (vertex_id i = 0; i < n; ++i)
+            c[key[i].second] = i;
+        return c;
+    }
+};
+
+//  Memetic search: a population of orderings, improved by sifting, evolves by crossover,
+//  perturbation and sifting of the offspring. The offspring of a generation are produced
+//  at the same time by the workers of a work_stealing_pool, that of the caller if it is a
+//  worker; each replaces the worst individual if it is better and its weight is not in the
+//  population yet.
+//  The initial population comes from the given solvers, run in turn on random relabelings
+//  of the graph. Every improvement of the best ordering is reported to on_improve.
+//  The search stops after time_limit seconds. Sifting shares that limit and may stop in the
+//  middle of a pass, so the result depends on the seed and on the timing of the run, and two
+//  runs with the same seed can differ.
+template<class Graph>
+struct memetic_search {
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_weight_t<Graph> edge_weight;
+    typedef edge_t<Graph> edge_type;
+
+    struct individual {
+        solution<Graph> rk;
+        edge_weight w;
+    };
+
+    vector<solver<Graph>> seeds;
+    double time_limit;
+    std::uint64_t seed;
+    std::size_t population = 8;
+    double mutation = 0.001;        //  Fraction of the vertices moved by the perturbation
+    function<void(const solution<Graph>&, edge_weight)> on_improve;
+
+    memetic_search(vector<solver<Graph>> seeds_, double time_limit_, std::uint64_t seed_)
+        : seeds(std::move(seeds_)), time_limit(time_limit_), seed(seed_) {}
+
+    //  s applied to g with its vertices relabeled by a random permutation
+    solution<Graph> solve_relabeled(const Graph& g, const solver<Graph>& s, std::mt19937_64& rng) const {
+        const vertex_id n = g.num_vertices();
+        vector<vertex_id> p(n);
+        std::iota(p.begin(), p.end(), 0);
+        std::shuffle(p.begin(), p.end(), rng);
+        vector<edge_type> es;
+        es.reserve(g.num_edges());
+        for (const edge_type& e : g.edges())
+            es.emplace_back(p[e.src], p[e.dst], e.weight);
+        std::shuffle(es.begin(), es.end(), rng);
+        solution<Graph> rk = s(Graph(n, es.begin(), es.end()));
+        solution<Graph> res(n);
+        for (vertex_id v = 0; v < n; ++v)
+            res[v] = rk[p[v]];
+        return res;
+    }
+
+    solution<Graph> operator()(const Graph& g) {
+        const vertex_id n = g.num_vertices();
+        if (n <= 1 || seeds.empty()) return trivial_solver(g);
+        const auto t0 = std::chrono::steady_clock::now();
+        auto remaining = [&]() {
+            return time_limit - std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        };
+        std::mt19937_64 rng(seed);
+        vector<individual> pop;
+        individual best;
+        best.w = -1;
+        auto update = [&](const individual& x) {
+            if (best.w == -1 || x.w < best.w) {
+                best = x;
+                if (on_improve) on_improve(best.rk, best.w);
+            }
+        };
+
+        //  The seeds and the sifting run on the same workers as the offspring
+        util::pool_ref pool;
+
+        //  The first individual is produced even without time left. A time limit of 0 would
+        //  let the sifting run to the end.
+        for (std::size_t i = 0; i < population && (i == 0 || remaining() > 0); ++i) {
+            const solver<Graph>& s = seeds[i % seeds.size()];
+            individual x;
+            x.rk = i < seeds.size() ? s(g) : solve_relabeled(g, s, rng);
+            x.rk = improver_sifting<Graph>(std::max(remaining(), 1e-9))(g, x.rk);
+            x.w = get_fas_weight(g, x.rk);
+            update(x);
+            pop.push_back(std::move(x));
+        }
+
+        const std::size_t k = std::max(2u, pool->num_workers());
+        const vertex_id moved = std::max<vertex_id>(1, n * mutation);
+        while (pop.size() > 1 && remaining() > 0) {
+            vector<std::uint64_t> rs(3 * k);
+            for (auto& r : rs) r = rng();
+            vector<individual> off(k);
+            {
+                util::task_group tg(*pool);
+                for (std::size_t j = 0; j < k; ++j)
+                    tg.spawn([&, j]() {
+                        const std::size_t p = pop.size(), ia = rs[3 * j] % p;
+                        const individual& a = pop[ia];
+                        const individual& b = pop[(ia + 1 + rs[3 * j] / p % (p - 1)) % p];
+                        solution<Graph> c = crossover_order<Graph>(rs[3 * j + 1])(g, a.rk, b.rk);
+                        c = perturber_insertion<Graph>(rs[3 * j + 2], moved)(g, c);
+                        off[j].rk = improver_sifting<Graph>(std::max(remaining(), 1e-9))(g, c);
+                        off[j].w = get_fas_weight(g, off[j].rk);
+                    });
+                tg.sync();
+            }
+            for (individual& x : off) {
+                update(x);
+                auto worst = std::max_element(pop.begin(), pop.end(),
+                    [](const individual& p, const individual& q) { return p.w < q.w; });
+                bool dup = std::any_of(pop.begin(), pop.end(), [&](const individual& p) { return p.w == x.w; });
+                if (x.w < worst->w && !dup)
+                    *worst = std::move(x);
+            }
+        }
+        return best.rk;
+    }
+};
+
+}
+
+#endif
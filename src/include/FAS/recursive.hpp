@@ -1,6 +1,12 @@
 #ifndef FAS_SOLVER_RECURSIVE_HPP
 #define FAS_SOLVER_RECURSIVE_HPP
+#include <map>
+#include <set>
 #include <tuple>
+#include <util/profile.hpp>
+#include <util/work_stealing.hpp>
+#include <graph/scc.hpp>
+#include <graph/partitioned.hpp>
 #include <graph/algorithms.hpp>
 #include <FAS/common.hpp>
 
@@ -26,6 +32,7 @@ Graph coalease(const Graph& g, const coloring_result<Graph>& c) {
 
 template<class Graph>
 partition_result<Graph> partition(const Graph& g, const coloring_result<Graph>& c) {
+    util::profile::scope prof("partition");
     typedef edge_t<Graph> edge_type;
     typedef vertex_id_t<Graph> vertex_id;
     const vertex_id n = g.num_vertices();
@@ -63,6 +70,7 @@ template<class Graph>
 solution<Graph> default_assemble(const vertex_id_t<Graph>& n,
     const partition_result<Graph>& p,
     const vector<solution<Graph>>& sv) {
+    util::profile::scope prof("assemble");
     typedef vertex_id_t<Graph> vertex_id;
     const vertex_id k = p.first.num_vertices();
     vertex_id c = 0;
@@ -110,14 +118,89 @@ solution<Graph> hybrid_assemble(const Graph& g,
     return sg;
 }
 
+//  Optimal merge of two orderings a and b of disjoint vertex sets, keeping the order inside each.
+//  Placing a[i] after exactly x vertices of b costs the arcs from a[i] to b[0, x) and the arcs
+//  from b[x, n2) to a[i]. The cost changes of a[i] are given as steps { i, x, w }: the cost of
+//  a[i] changes by w between x - 1 and x, and steps must be sorted by i.
+//  With G_i the prefix minimum of the cost of a[0, i], G_i is nonincreasing, and only its drops
+//  are stored. The drops added and removed at each i are logged and undone in reverse, to
+//  find the last drop at or before the bound left by a[i + 1].
+//  Returns the number of vertices of b placed before each a[i].
+//  O(n1 + c log c) time and O(n1 + c) space for c steps.
+template<class V, class W>
+struct merge_step {
+    V i, x;
+    W w;
+};
+
+template<class V, class W>
+vector<V> dp_merge(V n1, V n2, const vector<merge_step<V, W>>& st) {
+    std::map<V, W> d;                           //  Drops of G, all negative
+    vector<pair<V, bool>> log;                  //  Drop added or removed
+    vector<pair<V, size_t>> act;                //  (i, end of its log) for each i with steps
+    for (size_t k = 0; k < st.size(); ) {
+        const V i = st[k].i;
+        size_t l = k;
+        while (k < st.size() && st[k].i == i) ++k;
+        for (size_t q = l; q < k; ++q)
+            if (st[q].w < 0) {
+                auto res = d.emplace(st[q].x, 0);
+                if (res.second) log.emplace_back(st[q].x, true);
+                res.first->second += st[q].w;
+            }
+        //  A rise cancels the drops after it
+        for (size_t q = l; q < k; ++q) {
+            if (st[q].w <= 0) continue;
+            W r = st[q].w;
+            auto it = d.lower_bound(st[q].x);
+            while (r > 0 && it != d.end()) {
+                if (-it->second <= r) {
+                    r += it->second;
+                    log.emplace_back(it->first, false);
+                    it = d.erase(it);
+                }
+                else {
+                    it->second += r;
+                    r = 0;
+                }
+            }
+        }
+        act.emplace_back(i, log.size());
+    }
+
+    std::set<V> s;
+    for (const auto& e : d)
+        s.insert(e.first);
+    vector<V> res(n1);
+    V bound = n2;
+    size_t t = act.size();
+    for (V i = n1; i-- > 0; ) {
+        while (t > 0 && act[t - 1].first > i) {
+            size_t l = t > 1 ? act[t - 2].second : 0;
+            for (size_t q = act[t - 1].second; q-- > l; ) {
+                if (log[q].second) s.erase(log[q].first);
+                else s.insert(log[q].first);
+            }
+            --t;
+        }
+        auto it = s.upper_bound(bound);
+        bound = it == s.begin() ? 0 : *--it;
+        res[i] = bound;
+    }
+    return res;
+}
+
+//  Merge the solutions of the parts one by one in the order found by s on the coarse graph,
+//  each time with the optimal merge of dp_merge. Only the arcs between the merged vertices
+//  and the new part are scanned, so the graph needs in_edges.
 template<class Graph>
 solution<Graph> dp_assemble(const Graph& g,
     const partition_result<Graph>& p,
     const vector<solution<Graph>>& sv,
     const solver<Graph>& s) {
     typedef vertex_id_t<Graph> vertex_id;
-    
     typedef edge_weight_t<Graph> edge_weight;
+    typedef merge_step<vertex_id, edge_weight> step;
 
     const Graph& h = p.first;
     const vertex_id k = h.num_vertices(), n = g.num_vertices();
@@ -125,73 +208,57 @@ solution<Graph> dp_assemble(const Graph& g,
     for (vertex_id i = 0; i < k; ++i)
         seqh[rkh[i]] = i;
 
-    solution<Graph> cur;
+    solution<Graph> cur, tmp, nxt;
+    vector<vertex_id> rk(n, n);     //  Index in cur, n if not merged yet
+    vector<step> st;
+    cur.reserve(n);
     for (vertex_id i = 0; i < k; ++i) {
         vertex_id id = seqh[i];
-        const vector<vertex_id> id_map = p.second[id].first;
-        const Graph& gi = p.second[id].second;
+        const vector<vertex_id>& id_map = p.second[id].first;
         const solution<Graph>& sgi = sv[id];
         vertex_id n1 = cur.size(), n2 = sgi.size();
-        solution<Graph> tmp(n2);
+        tmp.resize(n2);
         for (vertex_id j = 0; j < n2; ++j)
             tmp[sgi[j]] = id_map[j];
-        vector<vector<edge_weight>> dp(n1 + 1, vector<edge_weight>(n2 + 1, 0));
-        vector<vector<edge_weight>> sum1(n1 + 1, vector<edge_weight>(n2 + 1, 0));
-        vector<vector<edge_weight>> sum2(n2 + 1, vector<edge_weight>(n1 + 1, 0));
-        
-        vector<vertex_id> rk1(n, n), rk2(n, n);
-        for (vertex_id i1 = 0; i1 < n1; ++i1)
-            rk1[cur[i1]] = i1;
-        for (vertex_id i2 = 0; i2 < n2; ++i2)
-            rk2[tmp[i2]] = i2;
-
-        for (vertex_id i1 = 0; i1 < n1; ++i1)
-            for (const edge_t<Graph>& e : g.out_edges(cur[i1]))
-                if (rk2[e.dst] != n)
-                    sum1[i1 + 1][rk2[e.dst] + 1] += e.weight;
-
-        for (vertex_id i2 = 0; i2 < n2; ++i2)
-            for (const edge_t<Graph>& e : g.out_edges(tmp[i2]))
-                if (rk1[e.dst] != n)
-                    sum2[i2 + 1][rk1[e.dst] + 1] += e.weight;
-
-        for (vertex_id i1 = 1; i1 <= n1; ++i1)
-            for (vertex_id i2 = 1; i2 <= n2; ++i2)
-                sum1[i1][i2] += sum1[i1][i2 - 1];
-        
-        for (vertex_id i2 = 1; i2 <= n2; ++i2)
-            for (vertex_id i1 = 1; i1 <= n1; ++i1)
-                sum2[i2][i1] += sum2[i2][i1 - 1];
-        
-        for (vertex_id i1 = 1; i1 <= n1; ++i1)
-            for (vertex_id i2 = 1; i2 <= n2; ++i2)
-                dp[i1][i2] = min(dp[i1 - 1][i2] + sum1[i1][i2], dp[i1][i2 - 1] + sum2[i2][i1]);
-
-        solution<Graph> n_cur;
-        vertex_id i1 = n1, i2 = n2;
-        while (i1 != 0 || i2 != 0) {
-            if (i2 == 0)
-                n_cur.push_back(cur[--i1]);
-            else if (i1 == 0)
-                n_cur.push_back(tmp[--i2]);
-            else {
-                if (dp[i1][i2] == dp[i1 - 1][i2] + sum1[i1][i2])
-                    n_cur.push_back(cur[--i1]);
-                else 
-                    n_cur.push_back(tmp[--i2]);
-            }
+
+        st.clear();
+        for (vertex_id j = 0; j < n2; ++j) {
+            for (const edge_t<Graph>& e : g.out_edges(tmp[j]))
+                if (rk[e.dst] != n)
+                    st.push_back({ rk[e.dst], j + 1, -e.weight });
+            for (const edge_t<Graph>& e : g.in_edges(tmp[j]))
+                if (rk[e.src] != n)
+                    st.push_back({ rk[e.src], j + 1, e.weight });
         }
-        reverse(n_cur.begin(), n_cur.end());
-        cur = move(n_cur);
+        sort(st.begin(), st.end(), [](const step& x, const step& y) {
+            return x.i < y.i || (x.i == y.i && x.x < y.x);
+        });
+        vector<vertex_id> before = dp_merge(n1, n2, st);
+
+        nxt.clear();
+        vertex_id j = 0;
+        for (vertex_id i1 = 0; i1 < n1; ++i1) {
+            while (j < before[i1])
+                nxt.push_back(tmp[j++]);
+            nxt.push_back(cur[i1]);
+        }
+        while (j < n2)
+            nxt.push_back(tmp[j++]);
+        swap(cur, nxt);
+        for (vertex_id i1 = 0; i1 < (vertex_id)cur.size(); ++i1)
+            rk[cur[i1]] = i1;
     }
-    solution<Graph> rk(n);
+    solution<Graph> res(n);
     for (vertex_id i = 0; i < n; ++i)
-        rk[cur[i]] = i;
-    return rk;
+        res[cur[i]] = i;
+    return res;
 }
 
+//  Subgraphs with fewer vertices are solved by the task that decomposed them
+constexpr size_t recurse_spawn_size = 1024;
+
 template<class Graph, class Tpl, size_t I>
-solution<Graph> recurse_impl(const Graph& g,
+solution<Graph> recurse_impl(util::work_stealing_pool& pool, const Graph& g,
     const solver<Graph>& s, vertex_id_t<Graph> t,
     Tpl&& tpl, integral_constant<size_t, I>
     ) {
@@ -200,18 +267,99 @@ solution<Graph> recurse_impl(const Graph& g,
 
     decay_t<std::tuple_element_t<I, decay_t<Tpl>>> d(get<I>(tpl));  //  Use copy construction, no move.
     partition_result<Graph> dres = d.decompose(g);
-    vector<solution<Graph>> sres;
-    for (const auto& h : dres.second)
-        sres.push_back(recurse_impl(h.second, s, t, forward<Tpl>(tpl),
-        integral_constant<size_t, (I + 1) % std::tuple_size_v<decay_t<Tpl>>>()));
+    vector<solution<Graph>> sres(dres.second.size());
+    {
+        util::task_group tg(pool);
+        for (size_t i = 0; i < dres.second.size(); ++i) {
+            auto sub = [&, i]() {
+                sres[i] = recurse_impl(pool, dres.second[i].second, s, t, tpl,
+                    integral_constant<size_t, (I + 1) % std::tuple_size_v<decay_t<Tpl>>>());
+            };
+            if (size_t(dres.second[i].second.num_vertices()) < recurse_spawn_size)
+                sub();
+            else
+                tg.spawn(sub);
+        }
+        tg.sync();
+    }
     return d.assemble(g, dres, sres);
 }
 
+//  Subgraphs are solved as tasks of a work-stealing pool with util::num_threads() workers, or of
+//  the pool of the caller if it is a worker. The decomposers and the solver may be called from
+//  several threads at the same time.
 template<class Graph, class Tpl>
 solution<Graph> recurse(const Graph& g,
     const solver<Graph>& s, vertex_id_t<Graph> t,
     Tpl&& tpl) {
-    return recurse_impl(g, s, t, forward<Tpl>(tpl), integral_constant<size_t, 0>());
+    util::pool_ref pool;
+    return recurse_impl(*pool, g, s, t, tpl, integral_constant<size_t, 0>());
+}
+
+//  Whether a decomposer D for recurse_in_place may reorder its parts after they are solved, with
+//  assemble(parts, p, res) where the parts hold positions [p, p + size) of res in their order
+template<class D, class Graph, class = void>
+struct assembles_in_place : std::false_type {};
+
+template<class D, class Graph>
+struct assembles_in_place<D, Graph, std::void_t<decltype(std::declval<D&>().assemble(
+    std::declval<const vector<partition_view<Graph>>&>(), vertex_id_t<Graph>(), std::declval<solution<Graph>&>()))>>
+    : std::true_type {};
+
+template<class Graph, class Tpl, size_t I>
+void recurse_in_place_impl(util::task_group& tg, partitioned_graph<Graph>& pg,
+    const partition_view<Graph>& x, vertex_id_t<Graph> p,
+    const solver<partition_view<Graph>>& s, vertex_id_t<Graph> t,
+    Tpl& tpl, integral_constant<size_t, I>, solution<Graph>& res) {
+    typedef vertex_id_t<Graph> vertex_id;
+    if (x.num_vertices() <= t) {
+        solution<partition_view<Graph>> rk = s(x);
+        for (vertex_id i = 0; i < x.num_vertices(); ++i)
+            res[x.original_id(i)] = p + rk[i];
+        return;
+    }
+
+    decay_t<std::tuple_element_t<I, decay_t<Tpl>>> d(get<I>(tpl));  //  Use copy construction, no move.
+    typedef integral_constant<size_t, (I + 1) % std::tuple_size_v<decay_t<Tpl>>> next;
+    const vector<partition_view<Graph>> parts = d.decompose(pg, x);
+    auto solve_parts = [&](util::task_group& g) {
+        vertex_id q = p;
+        for (const partition_view<Graph>& y : parts) {
+            if (size_t(y.num_vertices()) < recurse_spawn_size)
+                recurse_in_place_impl(g, pg, y, q, s, t, tpl, next(), res);
+            else
+                g.spawn([&g, &pg, y, q, &s, t, &tpl, &res]() { recurse_in_place_impl(g, pg, y, q, s, t, tpl, next(), res); });
+            q += y.num_vertices();
+        }
+    };
+    if constexpr (assembles_in_place<decltype(d), Graph>::value) {
+        if (d.assembles_in_place()) {
+            //  The parts are reordered together once all of them are solved
+            util::task_group sub(tg.get_pool());
+            solve_parts(sub);
+            sub.sync();
+            d.assemble(parts, p, res);
+            return;
+        }
+    }
+    solve_parts(tg);
+}
+
+//  Same as recurse, on a single partitioned copy of g instead of a new graph for every part.
+//  Each decomposer splits a view in place with decompose(partitioned_graph<Graph>&, view) and
+//  returns the parts in the order they take in the solution. A decomposer whose
+//  assembles_in_place() is true then reorders the solved parts with assemble.
+template<class Graph, class Tpl>
+solution<Graph> recurse_in_place(const Graph& g,
+    const solver<partition_view<Graph>>& s, vertex_id_t<Graph> t,
+    Tpl&& tpl) {
+    partitioned_graph<Graph> pg(g);
+    solution<Graph> res(g.num_vertices());
+    util::pool_ref pool;
+    util::task_group tg(*pool);
+    recurse_in_place_impl(tg, pg, pg.whole(), 0, s, t, tpl, integral_constant<size_t, 0>(), res);
+    tg.sync();
+    return res;
 }
 
 template<class Graph>
@@ -221,6 +369,10 @@ struct decomposer_scc {
         return partition(g, strongly_connected_components(g));
     }
 
+    vector<partition_view<Graph>> decompose(partitioned_graph<Graph>& pg, const partition_view<Graph>& x) {
+        return pg.split(x, strongly_connected_components(x));
+    }
+
     solution<Graph> assemble(const Graph& g, const partition_result<Graph>& dres, const vector<solution<Graph>>& sres) {
         return default_assemble(g, dres, sres);
         //return hybrid_assemble(g, dres, sres, solver<graph>(greedy<graph>));
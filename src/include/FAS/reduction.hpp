@@ -2,7 +2,9 @@
 #define FAS_REDUCTION_HPP
 #include <list>
 #include <queue>
-#include <ext/pb_ds/assoc_container.hpp>
+#include <util/adjacency_store.hpp>
+#include <util/profile.hpp>
+#include <util/work_stealing.hpp>
 #include <graph/scc.hpp>
 #include <graph/algorithms.hpp>
 #include <FAS/common.hpp>
@@ -22,7 +24,7 @@ struct fastred {
     typedef edge_weight_t<Graph> edge_weight;
     typedef edge_t<Graph> edge;
 
-    typedef __gnu_pbds::gp_hash_table<vertex_id, edge_weight> edge_container;
+    typedef util::adjacency_store<vertex_id, edge_weight> edge_container;
 
     enum stat_t { normal = 0, inqueue = 1, deleted = 2 };
 
@@ -31,15 +33,13 @@ struct fastred {
 
     vector<vertex_id> s, id;
     typedef pair<typename vector<vertex_id>::iterator, typename vector<vertex_id>::iterator> pii;
-    list<pii> k;
     vector<list<vertex_id>> l;
 
-    vector<edge_container> g, h;
+    edge_container g, h;
     vector<edge_weight> gs, hs;
 
     typedef pair<vertex_id, edge_weight> pvw;
     typedef pair<edge_weight, vertex_id> pwv;
-    queue<vertex_id> q;
     vector<priority_queue<pwv>> gq, hq;
     vector<pwv> gc, hc;
     const pwv nil = { 0, 0 };
@@ -54,9 +54,23 @@ struct fastred {
         return h[u].size() == 1 ? pwv(h[u].begin()->second, h[u].begin()->first) : nil;
     }
 
-    void enqueue(vertex_id u) {
+    //  Scratch space of a worker. Components are processed concurrently, and each
+    //  of them only touches the per-vertex state of its own vertices.
+    struct context {
+        queue<vertex_id> q;
+        vertex_id color_num, dfc;
+        vector<vertex_id> stk;
+        vector<pair<vertex_id, typename edge_container::const_iterator>> ctx;
+        vector<pair<vertex_id, vertex_id>> par_es;
+        edge_weight forced = 0;
+        std::uint64_t contractions = 0, cancelled = 0, loops = 0;
+    };
+    vector<context> cs;
+    edge_weight forced0 = 0;
+
+    void enqueue(context& c, vertex_id u) {
         if (stat[u] != normal) return;
-        q.push(u);
+        c.q.push(u);
         stat[u] = inqueue;
     }
 
@@ -83,9 +97,9 @@ struct fastred {
     }
 
     //  Find new contractible arcs
-    void checkq(vertex_id u) {
+    void checkq(context& c, vertex_id u) {
         if (checkg(u) || checkh(u))
-            enqueue(u);
+            enqueue(c, u);
         while (!gq[u].empty()) {
             pwv p = gq[u].top();
             vertex_id v = p.second;
@@ -94,7 +108,7 @@ struct fastred {
                 if (w < gs[u])
                     break;
                 else
-                    enqueue(v);
+                    enqueue(c, v);
             }
             gq[u].pop();
             gc[v] = nil;
@@ -107,7 +121,7 @@ struct fastred {
                 if (w < hs[u])
                     break;
                 else
-                    enqueue(v);
+                    enqueue(c, v);
             }
             hq[u].pop();
             hc[v] = nil;
@@ -122,8 +136,10 @@ struct fastred {
         h[v].erase(u);
     }
 
-    void add_edge(vertex_id u, vertex_id v, edge_weight w) {
-        if (u == v) return;
+    //  Returns the weight that every ordering keeping the contracted vertices together
+    //  has to pay: a self-loop, or the cancelled part of a two-cycle
+    edge_weight add_edge(vertex_id u, vertex_id v, edge_weight w) {
+        if (u == v) return w;
         auto it = g[v].find(u);         //  Find reverse arc
         if (it == g[v].end()) {         //  Reverse arc not exist
             auto res = g[u].insert({ v, w });
@@ -135,6 +151,7 @@ struct fastred {
                 res.first->second += w;
                 h[v][u] += w;
             }
+            return 0;
         }
         else {                              //  Reverse arc exists
             if (it->second > w) {           //  Decrease its weight
@@ -142,9 +159,11 @@ struct fastred {
                 h[u][v] -= w;
                 gs[v] -= w;
                 hs[u] -= w;
+                return w;
             }
             else {                          //  Remove reverse arc 
-                w -= it->second;
+                edge_weight r = it->second;
+                w -= r;
                 gs[v] -= it->second;
                 hs[u] -= it->second;
                 g[v].erase(u);
@@ -155,11 +174,21 @@ struct fastred {
                     gs[u] += w;
                     hs[v] += w;
                 }
+                return r;
             }
         }
     }
 
-    void contract(vertex_id u, vertex_id v) {
+    //  add_edge, counting the self-loops and cancelled two-cycles it pays for in c
+    void add_forced(context& c, vertex_id u, vertex_id v, edge_weight w) {
+        edge_weight x = add_edge(u, v, w);
+        if (x == 0) return;
+        c.forced += x;
+        ++(u == v ? c.loops : c.cancelled);
+    }
+
+    void contract(context& c, vertex_id u, vertex_id v) {
+        ++c.contractions;
         del_edge(u, v);
         //  Merge vertex with smaller degree into vertex with larger degree
         if (g[u].size() + h[u].size() > g[v].size() + h[v].size()) {
@@ -172,18 +201,18 @@ struct fastred {
         vector<pvw> gu(g[u].begin(), g[u].end()), hu(h[u].begin(), h[u].end());
         for (const pvw& e : gu) {
             del_edge(u, e.first);
-            add_edge(v, e.first, e.second);
+            add_forced(c, v, e.first, e.second);
         }
         for (const pvw& e : hu) {
             del_edge(e.first, u);
-            add_edge(e.first, v, e.second);
+            add_forced(c, e.first, v, e.second);
         }
         for (const pvw& e : gu) checkc(e.first);
         for (const pvw& e : hu) checkc(e.first);
         checkc(v);
-        for (const pvw& e : gu) checkq(e.first);
-        for (const pvw& e : hu) checkq(e.first);
-        checkq(v);
+        for (const pvw& e : gu) checkq(c, e.first);
+        for (const pvw& e : hu) checkq(c, e.first);
+        checkq(c, v);
         g[u].clear();
         h[u].clear();
         gq[u] = priority_queue<pwv>();
@@ -191,26 +220,26 @@ struct fastred {
         stat[u] = deleted;
     }
 
-    void reduction(pii& x) {
+    void reduction(context& c, pii& x) {
         for (auto it = x.first; it != x.second; ++it)
             checkc(*it);
         for (auto it = x.first; it != x.second; ++it)
-            checkq(*it);
-        while (!q.empty()) {
-            vertex_id u = q.front(); q.pop();
+            checkq(c, *it);
+        while (!c.q.empty()) {
+            vertex_id u = c.q.front(); c.q.pop();
             if (stat[u] == deleted) continue;
             stat[u] = normal;
             if (checkh(u))
-                contract(geth(u).second, u);
+                contract(c, geth(u).second, u);
             else if (checkg(u))
-                contract(u, getg(u).second);
+                contract(c, u, getg(u).second);
             else
                 checkc(u);
         }
         x.second = remove_if(x.first, x.second, [&](vertex_id v) { return stat[v] == deleted; });
     }
 
-    void contract_chain(pii& x) {
+    void contract_chain(context& c, pii& x) {
         for (auto it = x.first; it != x.second; ++it) {
             vertex_id u = *it;
             pwv pg = getg(u), ph = geth(u);
@@ -218,7 +247,8 @@ struct fastred {
                 vertex_id vl = ph.second, vr = pg.second;
                 del_edge(vl, u);
                 del_edge(u, vr);
-                add_edge(vl, vr, min(ph.first, pg.first));
+                ++c.contractions;
+                add_forced(c, vl, vr, min(ph.first, pg.first));
                 if (ph.first < pg.first)
                     l[vr].splice(l[vr].begin(), l[u]);
                 else
@@ -229,13 +259,13 @@ struct fastred {
         x.second = remove_if(x.first, x.second, [&](vertex_id v) { return stat[v] == deleted; });
     }
 
-    vertex_id color_num, dfc;
-    vector<vertex_id> dfn, low, color, stk, inst;
-    vector<pair<vertex_id, typename edge_container::const_iterator>> ctx;
-    void scc_dfs(vertex_id x) {
+    vector<vertex_id> dfn, low, color, inst;
+    void scc_dfs(context& c, vertex_id x) {
+        auto& ctx = c.ctx;
+        auto& stk = c.stk;
         ctx.emplace_back(x, g[x].begin());
         stk.push_back(x); inst[x] = 1;
-        dfn[x] = low[x] = dfc++;
+        dfn[x] = low[x] = c.dfc++;
         while (!ctx.empty()) {
             vertex_id u = ctx.back().first;
             typename edge_container::const_iterator it = ctx.back().second, it_end = g[u].end();
@@ -248,7 +278,7 @@ struct fastred {
                     ctx.emplace_back(v, g[v].begin());
                     stk.push_back(v); inst[v] = 1;
                     // vis[v] = 1;
-                    dfn[v] = low[v] = dfc++;
+                    dfn[v] = low[v] = c.dfc++;
                 }
                 else if (inst[v])
                     low[u] = std::min(low[u], dfn[v]);
@@ -262,31 +292,31 @@ struct fastred {
                         v = stk.back();
                         stk.pop_back();
                         inst[v] = 0;
-                        color[v] = color_num;
+                        color[v] = c.color_num;
                     } while (v != u);
-                    ++color_num;
+                    ++c.color_num;
                 }
             }
         }
     }
 
-    void scc_decomp(const pii& x) {
-        color_num = dfc = 0;
+    void scc_decomp(context& c, const pii& x) {
+        c.color_num = c.dfc = 0;
         for (auto it = x.first; it != x.second; ++it)
             dfn[*it] = n;
         for (auto it = x.first; it != x.second; ++it)
             if (dfn[*it] == n)
-                scc_dfs(*it);
+                scc_dfs(c, *it);
         for (auto it = x.first; it != x.second; ++it)
-            color[*it] = color_num - color[*it] - 1;
+            color[*it] = c.color_num - color[*it] - 1;
     }
 
-    vector<pair<vertex_id, vertex_id>> par_es;
-    vector<pii> partition(const pii& x) {
+    vector<pii> partition(context& c, const pii& x) {
+        auto& par_es = c.par_es;
         // vertex_id n2 = x.second - x.first;
         sort(x.first, x.second, [&](vertex_id u, vertex_id v) { return color[u] < color[v]; });
         vector<pii> res;
-        res.reserve(color_num);
+        res.reserve(c.color_num);
         
         for (auto it = x.first; it != x.second; ++it) {
             vertex_id u = *it;
@@ -304,10 +334,82 @@ struct fastred {
         for (auto e : par_es)
             del_edge(e.first, e.second);
         par_es.clear();
+        //  Drop the contraction candidates, which may refer to vertices of the other parts.
+        //  reduction() finds them again from the remaining arcs.
+        if (res.size() > 1)
+            for (auto it = x.first; it != x.second; ++it) {
+                vertex_id u = *it;
+                gq[u] = priority_queue<pwv>();
+                hq[u] = priority_queue<pwv>();
+                gc[u] = hc[u] = nil;
+            }
         return res;
     }
 
+    //  Number of vertices of the input graph contracted into the vertices of x
+    vertex_id original_size(const pii& x) {
+        vertex_id r = 0;
+        for (auto it = x.first; it != x.second; ++it)
+            r += l[*it].size();
+        return r;
+    }
+
+    //  Reduce and split component x, whose vertices take positions from p on in res
+    void process(util::task_group& tg, pii x, vertex_id p, const solver<Graph>& sol, solution<Graph>& res) {
+        context& c = cs[util::work_stealing_pool::worker_index()];
+        if constexpr (ArcContraction) {
+            if constexpr (ContractChainOnly)
+                contract_chain(c, x);
+            else
+                reduction(c, x);
+        }
+        scc_decomp(c, x);
+        vector<pii> scc_res = partition(c, x);
+        if (RecSCC && c.color_num > 1) {
+            for (const pii& y : scc_res) {
+                vertex_id py = p;
+                p += original_size(y);
+                if (y.second - y.first == 1) {
+                    for (vertex_id v : l[*y.first])
+                        res[v] = py++;
+                }
+                else
+                    tg.spawn([this, &tg, &sol, &res, y, py]() { process(tg, y, py, sol, res); });
+            }
+        }
+        else {
+            for (pii& y : scc_res) {
+                vertex_id n2 = y.second - y.first;
+                edge_id m2 = 0;
+                for (auto it3 = y.first; it3 != y.second; ++it3) {
+                    vertex_id u = *it3;
+                    m2 += g[u].size();
+                    id[u] = it3 - y.first;
+                }
+                vector<edge_t<Graph>> es; es.reserve(m2);
+                for (auto it3 = y.first; it3 != y.second; ++it3) {
+                    vertex_id u = *it3;
+                    for (auto e0 : g[u]) {
+                        vertex_id v = e0.first;
+                        edge e;
+                        e.src = id[u];
+                        e.dst = id[v];
+                        e.weight = e0.second;
+                        es.push_back(e);
+                    }
+                }
+                solution<Graph> pos = inv<Graph>(sol(Graph(n2, es.begin(), es.end())));
+                for (vertex_id u : pos)
+                    for (vertex_id v : l[y.first[u]])
+                        res[v] = p++;
+            }
+        }
+    }
+
+    //  Components are processed as tasks of a work-stealing pool with util::num_threads() workers,
+    //  or of the pool of the caller if it is a worker. The solver may be called from several threads at the same time.
     solution<Graph> solve(const Graph& g0, solver<Graph> sol) {
+        util::profile::scope prof("reduction");
         n = g0.num_vertices();
         id.resize(n, n);
         g.resize(n);
@@ -327,64 +429,45 @@ struct fastred {
 
         s.assign(n, 0);
         iota(s.begin(), s.end(), 0);
-        k.emplace_back(s.begin(), s.end());
 
         l.resize(n);
         for (vertex_id u = 0; u < n; ++u)
             l[u].push_back(u);
 
-        for (const auto& e : g0.edges())
-            add_edge(e.src, e.dst, e.weight);
-        
-        vertex_id p = 0;
         solution<Graph> res(n, n);
-        auto it = k.begin();
-        while (it != k.end()) {
-            pii x = *it;
-            if constexpr (ArcContraction) {
-                if constexpr (ContractChainOnly)
-                    contract_chain(x);
-                else
-                    reduction(x);
-            }
-            scc_decomp(x);
-            vector<pii> scc_res = partition(x);
-            auto it2 = next(it);
-            if (RecSCC && color_num > 1) {
-                for (const pii& y : scc_res)
-                    k.emplace(it2, y);
-            }
-            else {
-                for (pii& y : scc_res) {
-                    vertex_id n2 = y.second - y.first;
-                    edge_id m2 = 0;
-                    for (auto it3 = y.first; it3 != y.second; ++it3) {
-                        vertex_id u = *it3;
-                        m2 += g[u].size();
-                        id[u] = it3 - y.first;
-                    }
-                    vector<edge_t<Graph>> es; es.reserve(m2);
-                    for (auto it3 = y.first; it3 != y.second; ++it3) {
-                        vertex_id u = *it3;
-                        for (auto e0 : g[u]) {
-                            vertex_id v = e0.first;
-                            edge e;
-                            e.src = id[u];
-                            e.dst = id[v];
-                            e.weight = e0.second;
-                            es.push_back(e);
-                        }
-                    }
-                    solution<Graph> pos = inv<Graph>(sol(Graph(n2, es.begin(), es.end())));
-                    for (vertex_id u : pos)
-                        for (vertex_id v : l[y.first[u]])
-                            res[v] = p++;
-                }
+        util::pool_ref pool;
+        cs.resize(pool->num_workers());
+        forced0 = 0;
+        context c0;
+        for (const auto& e : g0.edges())
+            add_forced(c0, e.src, e.dst, e.weight);
+        forced0 = c0.forced;
+
+        util::task_group tg(*pool);
+        process(tg, pii(s.begin(), s.end()), 0, sol, res);
+        tg.sync();
+        if (util::profile::is_enabled()) {
+            for (const context& c : cs) {
+                c0.contractions += c.contractions;
+                c0.cancelled += c.cancelled;
+                c0.loops += c.loops;
             }
-            it = k.erase(it);
+            util::profile::count("contractions", c0.contractions);
+            util::profile::count("cancelled_2cycles", c0.cancelled);
+            util::profile::count("self_loops", c0.loops);
         }
         return res;
     }
+
+    //  Weight of the FAS paid by the reduction itself, after solve: the weight of the solution
+    //  is this plus the weights of the solutions of the components given to the solver, and so
+    //  is the minimum FAS with the minima of these components
+    edge_weight forced_weight() const {
+        edge_weight w = forced0;
+        for (const context& c : cs)
+            w += c.forced;
+        return w;
+    }
 };
 
 }
@@ -1,317 +1,227 @@
-#error "Incomplete! Don't use!"
 #ifndef GRAPH_DYNAMIC_HPP
 #define GRAPH_DYNAMIC_HPP
-#include <tagged_tuple.hpp>
+#include <iterator>
+#include <vector>
+#include <graph/common.hpp>
+#include <util/adjacency_store.hpp>
+#include <util/iterator_range.hpp>
 #include <util/pointer_proxy.hpp>
-
-#if __GNUC__ > 3 || \
-    (__GNUC__ == 3 && (__GNUC_MINOR__ > 2 || \
-                       (__GNUC_MINOR__ == 2 && \
-                        __GNUC_PATCHLEVEL__ > 0)))
-#define GRAPH_HAVE_PBDS 1
-#include <ext/pb_ds/assoc_container.hpp>
-#else 
-#define GRAPH_HAVE_PBDS 0
-#include <unordered_map>
-#endif
+#include <util/tagged_tuple.hpp>
 
 namespace graph {
 
-using namespace util;
+using util::tagged_tuple;
 
-using property::src;
-using property::dst;
-using property::weight;
+using util::property::src;
+using util::property::dst;
+using util::property::weight;
 
-template<class K1, class K2, class V>
-class dynamic_edge_container;
-
-template<class K1, class K2, class V>
-struct dynamic_edge_container_traits;
+template<class VertexSizeType, class EdgeSizeType, class EdgeWeightType>
+struct dynamic_graph_traits {
 
-template<class Traits>
-class dynamic_edge_container_iterator;
+    typedef VertexSizeType vertex_id_type;
 
-template<class Traits>
-class dynamic_edge_container_const_iterator;
+    typedef EdgeSizeType edge_id_type;
 
-template<class Traits>
-class dynamic_edge_container_iterator {
-    typedef dynamic_edge_container_iterator<Traits> this_type;
-public:
-    typedef typename Traits::value_type value_type;
-    typedef typename Traits::difference_type difference_type;
-    typedef typename Traits::reference reference;
-    typedef typename Traits::const_reference const_reference;
-    typedef typename Traits::pointer pointer;
-    typedef typename Traits::const_pointer const_pointer;
-
-    typedef typename Traits::edge_container edge_container;
-
-    typedef typename Traits::primary_key_type primary_key_type;
-    typedef typename Traits::primary_key_tag primary_key_tag;
-    typedef typename Traits::primary_key primary_key;
-    typedef typename Traits::secondary_key_type secondary_key_type;
-    typedef typename Traits::secondary_key_tag secondary_key_tag;
-    typedef typename Traits::secondary_key secondary_key;
-    
-    typedef typename Traits::adjacency_container::iterator iterator;
+    typedef EdgeWeightType edge_weight_type;
 
-private:
-    edge_container* c;
-    primary_key_type k;
-    iterator p;
+    typedef tagged_tuple<src<vertex_id_type>, dst<vertex_id_type>, weight<edge_weight_type>> edge_type;
 
-    dynamic_edge_container_iterator(edge_container* c_, primary_key_type k_, iterator p_) : c(c_), k(k_), p(p_) {}
+    typedef util::adjacency_store<vertex_id_type, edge_weight_type> adjacency_store;
+};
 
+//  Graph whose arcs are inserted and deleted in batches.
+//  Parallel arcs are merged into a single arc with the sum of their weights. Every vertex keeps
+//  maps of its outgoing and incoming arcs, so an arc is found, inserted or deleted in expected
+//  constant time. Adjacency lists and edges() yield edge_type values in no particular order,
+//  and are invalidated by any modification of the arcs of their vertices.
+template<class VertexSizeType, class EdgeSizeType, class EdgeWeightType>
+class dynamic_graph {
 public:
+    typedef dynamic_graph<VertexSizeType, EdgeSizeType, EdgeWeightType> this_type;
 
-    template<class K1, class K2, class V>
-    friend class dynamic_edge_container;
+    typedef dynamic_graph_traits<VertexSizeType, EdgeSizeType, EdgeWeightType> traits;
 
-    dynamic_edge_container_iterator() : c(nullptr) {}
-    dynamic_edge_container_iterator(const this_type&) = default;
-    dynamic_edge_container_iterator(this_type&&) = default;
+    typedef typename traits::vertex_id_type vertex_id_type;
+    typedef typename traits::edge_id_type edge_id_type;
 
-    reference operator*() const {
-        return tagged_tuple_cat(make_tagged_tuple<primary_key, secondary_key>(k, p->first), p->second);
-    }
+    typedef typename traits::edge_weight_type edge_weight_type;
 
-    pointer operator->() const {
-        return pointer(**this);
-    }
+    typedef typename traits::edge_type edge_type;
+    typedef edge_type out_edge_type;
+    typedef edge_type in_edge_type;
 
-    this_type& operator++() {
-        p++;
-        while (p == c[k].end()) {
-            k++;
-            p = c[k].begin();
-        }
-        return *this;
-    }
+private:
+    typedef typename traits::adjacency_store adjacency_store;
 
-    this_type operator++(int) {
-        this_type tmp = *this;
-        ++*this;
-        return tmp;
-    }
+    vertex_id_type m_n;
+    edge_id_type m_m;
+    //  Mutable since adjacency_store only hands out references that allow modification
+    mutable adjacency_store m_out_edges, m_in_edges;
 
-    this_type& operator--() {
-        while (p == c[k].begin()) {
-            k--;
-            p = c[k].end();
-        }
-        p--;
-        return *this;
-    }
+    template<bool Out>
+    class adjacency_iterator {
+        typename adjacency_store::iterator it;
+        vertex_id_type u;
 
-    this_type operator--(int) {
-        this_type tmp = *this;
-        --*this;
-        return tmp;
-    }
+        friend class dynamic_graph;
+        adjacency_iterator(typename adjacency_store::iterator it_, vertex_id_type u_) : it(it_), u(u_) {}
 
-};
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef edge_type reference;
+        typedef util::pointer_proxy<edge_type> pointer;
 
-template<class Traits>
-class dynamic_edge_container_slice;
+        adjacency_iterator() = default;
 
-template<template<class> class P1, class T1, template<class> class P2, class T2, class ...Ts>
-struct dynamic_edge_container_traits<P1<T1>, P2<T2>, tagged_tuple<Ts...>> {
-public:
-    typedef dynamic_edge_container<P1<T1>, P2<T2>, tagged_tuple<Ts...>> container_type;
-
-    typedef tagged_tuple<P1<T1>, P2<T2>, Ts...> value_type;
-    typedef tagged_tuple<Ts...> partial_value_type;
-    typedef size_t size_type;
-    typedef ptrdiff_t difference_type;
-    typedef add_qualifier_t<partial_value_type, std::add_lvalue_reference> partial_reference;
-    typedef add_qualifier_t<partial_value_type, std::add_const, std::add_lvalue_reference> partial_const_reference;
-
-    typedef tagged_tuple_cat_result_t<P1<const T1>, P2<const T2>, partial_reference> reference;
-    typedef tagged_tuple_cat_result_t<P1<const T1>, P2<const T2>, partial_const_reference> const_reference;
-
-    typedef pointer_proxy<reference> pointer;
-    typedef pointer_proxy<const_reference> const_pointer;
-
-    typedef P1<T1> primary_key;
-    typedef T1 primary_key_type;
-    typedef P1<void> primary_key_tag;
-    typedef P2<T2> secondary_key;
-    typedef T2 secondary_key_type;
-    typedef P2<void> secondary_key_tag;
-
-#if GRAPH_HAVE_PBDS
-    typedef __gnu_pbds::gp_hash_table<T2, partial_value_type> adjacency_container;
-#else
-    typedef std::unordered_map<T2, partial_value_type> adjacency_container;
-#endif
+        reference operator*() const {
+            return Out ? edge_type(u, it->first, it->second) : edge_type(it->first, u, it->second);
+        }
+        pointer operator->() const { return pointer(**this); }
+        adjacency_iterator& operator++() { ++it; return *this; }
+        adjacency_iterator operator++(int) { adjacency_iterator r = *this; ++it; return r; }
+        bool operator==(const adjacency_iterator& o) const { return it == o.it; }
+        bool operator!=(const adjacency_iterator& o) const { return it != o.it; }
+    };
+
+    class edge_iterator {
+        const dynamic_graph* g;
+        vertex_id_type u;
+        typename adjacency_store::iterator it;
+
+        friend class dynamic_graph;
+        edge_iterator(const dynamic_graph* g_, vertex_id_type u_) : g(g_), u(u_) {
+            if (u < g->m_n) it = g->m_out_edges[u].begin();
+            skip();
+        }
 
-    typedef std::vector<adjacency_container> edge_container;
+        void skip() {
+            while (u < g->m_n && it == g->m_out_edges[u].end())
+                if (++u < g->m_n) it = g->m_out_edges[u].begin();
+        }
 
-};
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef edge_type reference;
+        typedef util::pointer_proxy<edge_type> pointer;
+
+        edge_iterator() = default;
 
+        reference operator*() const { return edge_type(u, it->first, it->second); }
+        pointer operator->() const { return pointer(**this); }
+        edge_iterator& operator++() { ++it; skip(); return *this; }
+        edge_iterator operator++(int) { edge_iterator r = *this; ++*this; return r; }
+        bool operator==(const edge_iterator& o) const { return u == o.u && (u == g->m_n || it == o.it); }
+        bool operator!=(const edge_iterator& o) const { return !(*this == o); }
+    };
 
-template<template<class>class P1, class T1, template<class>class P2, class T2, class ...Ts>
-class dynamic_edge_container<P1<T1>, P2<T2>, tagged_tuple<Ts...>> {
 public:
-    
-    typedef dynamic_edge_container_traits<P1<T1>, P2<T2>, tagged_tuple<Ts...>> traits;
-    
-    typedef typename traits::value_type value_type;
-    typedef typename traits::size_type size_type;
-    typedef typename traits::difference_type difference_type;
-    typedef typename traits::reference reference;
-    typedef typename traits::const_reference const_reference;
-    typedef typename traits::pointer pointer;
-    typedef typename traits::const_pointer const_pointer;
-
-    typedef typename traits::adjacency_container adjacency_container;
-    typedef typename traits::edge_container edge_container;
-
-    typedef typename traits::primary_key primary_key;
-    typedef typename traits::primary_key_type primary_key_type;
-    typedef typename traits::primary_key_tag primary_key_tag;
-    typedef typename traits::secondary_key_type secondary_key_type;
-    typedef typename traits::secondary_key_tag secondary_key_tag;
-
-    typedef typename adjacency_container::iterator adjacency_iterator;
-    typedef typename adjacency_container::const_iterator adjacency_const_iterator;
-    typedef dynamic_edge_container_iterator<traits> iterator;
-    typedef dynamic_edge_container_const_iterator<traits> const_iterator;
-
-    edge_container c;
+    typedef adjacency_iterator<true> out_edge_iterator;
+    typedef adjacency_iterator<false> in_edge_iterator;
+    typedef util::iterator_range<out_edge_iterator> out_adjacency_container;
+    typedef util::iterator_range<in_edge_iterator> in_adjacency_container;
+    typedef util::iterator_range<edge_iterator> edge_container;
+
+    explicit dynamic_graph(vertex_id_type n = 0) : m_n(n), m_m(0), m_out_edges(n), m_in_edges(n) {}
 
     template<class FwdIt>
-    dynamic_edge_container(size_type n, FwdIt first, FwdIt last) : c(n) {
-        for (FwdIt it = first; it != last; ++it)
-            add_edge(*it);
+    dynamic_graph(vertex_id_type n, FwdIt begin_, FwdIt end_) : dynamic_graph(n) {
+        insert_edges(begin_, end_);
     }
 
-    template<class Tpl>
-    pair<iterator, bool> add_edge(Tpl&& tpl) {
-        auto res = c[tpl.get(primary_key_tag())].insert({ tpl.get(secondary_key_tag()), std::forward<Tpl>(tpl) });
-        return pair<iterator, bool>(iterator(&c, tpl.get(primary_key_tag()), res.first), res.second);
-    }
+    dynamic_graph(const this_type&) = delete;
+    this_type& operator=(const this_type&) = delete;
 
-    void del_edge(T1 u, T2 v) {
-        c[u].erase(v);
-    }
+    vertex_id_type num_vertices() const { return m_n; }
 
-    iterator find_edge(T1 u, T2 v) {
-        adjacency_iterator it = c[u].find(v);
-        if (it == c[u].end())
-            return end();
-        else 
-            return iterator(&c, u, it);
-    }
+    edge_id_type num_edges() const { return m_m; }
 
-    iterator find_edge(T1 u, T2 v) {
-        adjacency_iterator it = c[u].find(v);
-        if (it == c[u].end())
-            return end();
-        else 
-            return iterator(&c, u, it);
+    edge_container edges() const {
+        return { edge_iterator(this, 0), edge_iterator(this, m_n) };
     }
 
-    const_iterator find_edge(T1 u, T2 v) const {
-        adjacency_const_iterator it = c[u].find(v);
-        if (it == c[u].end())
-            return end();
-        else 
-            return const_iterator(&c, u, it);
+    out_adjacency_container out_edges(vertex_id_type v) const {
+        auto a = m_out_edges[v];
+        return { out_edge_iterator(a.begin(), v), out_edge_iterator(a.end(), v) };
     }
 
-};
-
-template<class VertexSizeType, class EdgeSizeType, class EdgeWeightType>
-struct dynamic_graph_traits {
-    
-    typedef VertexSizeType vertex_id_type;
-
-    typedef EdgeSizeType edge_id_type;
-
-    typedef EdgeWeightType edge_weight_type;
-
-    typedef tagged_tuple<src<vertex_id_type>, dst<vertex_id_type>, weight<edge_weight_type>> edge_type;
-    typedef tagged_tuple<src<vertex_id_type>, weight<edge_weight_type>> in_edge_type;
-    typedef tagged_tuple<dst<vertex_id_type>, weight<edge_weight_type>> out_edge_type;
-
-#if GRAPH_HAVE_PBDS
-    typedef __gnu_pbds::gp_hash_table<vertex_id_type, edge_weight_type> adjacency_container;
-#else 
-    typedef std::unordered_map<vertex_id_type, out_edge_type> out_adjacency_container;
-    typedef std::unordered_map<vertex_id_type, in_edge_type> in_adjacency_container;
-#endif
-    typedef std::vector<adjacency_container> edge_container;
-};
-
-template<class Traits>
-class dynamic_graph_adjacency_iterator : Traits::edge_container::iterator {
-public:
-    
-};
-
-template<class VertexSizeType, class EdgeSizeType, class EdgeWeightType>
-class dynamic_graph {
-public:
-    typedef dynamic_graph<VertexSizeType, EdgeSizeType, EdgeWeightType> this_type;
-
-    typedef dynamic_graph_traits<VertexSizeType, EdgeSizeType, EdgeWeightType> traits;
-
-    typedef typename traits::vertex_id_type vertex_id_type;
-    typedef typename traits::edge_id_type edge_id_type;
-
-    typedef typename traits::edge_weight_type edge_weight_type;
-
-    typedef typename traits::edge_type edge_type;
-
-    typedef typename traits::out_edge_container out_edge_container;
-    typedef typename traits::in_edge_container in_edge_container;
+    in_adjacency_container in_edges(vertex_id_type v) const {
+        auto a = m_in_edges[v];
+        return { in_edge_iterator(a.begin(), v), in_edge_iterator(a.end(), v) };
+    }
 
-    typedef typename out_edge_container::value_type out_edge_type;
-    typedef typename in_edge_container::value_type in_edge_type;
+    edge_id_type out_degree(vertex_id_type v) const { return m_out_edges[v].size(); }
 
-private:
-    vertex_id_type m_n;
-    in_edge_container m_in_edges;
-    out_edge_container m_out_edges;
-
-public:
-    dynamic_graph() = default;
-    dynamic_graph(const this_type&) = default;
-    dynamic_graph(this_type&&) = default;
+    edge_id_type in_degree(vertex_id_type v) const { return m_in_edges[v].size(); }
 
-    this_type& operator=(const this_type&) = default;
-    this_type& operator=(this_type&&) = default;
+    //  Weight of the arc (u, v), 0 if it does not exist
+    edge_weight_type edge_weight(vertex_id_type u, vertex_id_type v) const {
+        auto a = m_out_edges[u];
+        auto it = a.find(v);
+        return it == a.end() ? edge_weight_type(0) : it->second;
+    }
 
-    ~dynamic_graph() = default;
+    //  Add k isolated vertices, numbered from num_vertices() on
+    void add_vertices(vertex_id_type k) {
+        m_n += k;
+        m_out_edges.resize(m_n);
+        m_in_edges.resize(m_n);
+    }
 
-    template<class FwdIt>
-    dynamic_graph(vertex_id_type n, FwdIt begin_, FwdIt end_) : m_n(n), m_in_edges(n), m_out_edges(n) {
-        for (auto it = begin_; it != end_; ++it) {
-            m_in_edges[it->dst][it->src] += it->weight;
-            m_out_edges[it->src][it->dst] += it->weight;
+    //  Add w to the weight of the arc (u, v), inserting it if it does not exist
+    void insert_edge(vertex_id_type u, vertex_id_type v, edge_weight_type w) {
+        auto res = m_out_edges[u].insert({ v, w });
+        if (res.second) {
+            m_in_edges[v].insert({ u, w });
+            ++m_m;
+        }
+        else {
+            res.first->second += w;
+            m_in_edges[v].find(u)->second += w;
         }
     }
 
-    vertex_id_type num_vertices() const { return m_n; }
-
-    edge_id_type num_edges() const { return m_out_edges.size(); }
-
+    //  Delete the arc (u, v). Returns its weight, 0 if it did not exist.
+    edge_weight_type erase_edge(vertex_id_type u, vertex_id_type v) {
+        auto a = m_out_edges[u];
+        auto it = a.find(v);
+        if (it == a.end()) return 0;
+        edge_weight_type w = it->second;
+        a.erase(v);
+        m_in_edges[v].erase(u);
+        --m_m;
+        return w;
+    }
 
-    in_adjacency_container in_edges(vertex_id_type v) const {
-        return in_adjacency_container(m_in_edges.begin(v), m_in_edges.end(v));
+    //  Insert a batch of edges, each with src, dst and weight
+    template<class FwdIt>
+    void insert_edges(FwdIt first, FwdIt last) {
+        for (FwdIt it = first; it != last; ++it)
+            insert_edge(it->src, it->dst, it->weight);
     }
 
-    out_adjacency_container out_edges(vertex_id_type v) const {
-        return out_adjacency_container(m_out_edges.begin(v), m_out_edges.end(v));
+    //  Delete the arcs of a batch, given by src and dst. Returns the number of arcs deleted.
+    template<class FwdIt>
+    edge_id_type erase_edges(FwdIt first, FwdIt last) {
+        edge_id_type k = 0;
+        for (FwdIt it = first; it != last; ++it)
+            if (has_edge(it->src, it->dst)) {
+                erase_edge(it->src, it->dst);
+                ++k;
+            }
+        return k;
     }
 
+    bool has_edge(vertex_id_type u, vertex_id_type v) const {
+        auto a = m_out_edges[u];
+        return a.find(v) != a.end();
+    }
 };
 
-
 }
 
-
-#endif
\ No newline at end of file
+#endif
@@ -2,7 +2,16 @@
 #define GRAPH_IO_HPP
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
 #include <graph/common.hpp>
+#include <graph/static.hpp>
+#include <graph/webgraph.hpp>
+#include <util/mapped_file.hpp>
+#include <util/parallel.hpp>
+#include <util/profile.hpp>
 
 namespace graph {
 
@@ -192,6 +201,323 @@ pair<vertex_id_t<Graph>, vector<edge_t<Graph>>> read_graph_impl(istream& is, con
         return {};
 }
 
+//  Statistics of a call to read_graph_mmap
+struct read_stats {
+    std::size_t bytes = 0;
+    double seconds = 0;
+    unsigned threads = 0;
+
+    //  Parse throughput in MB/s
+    double throughput() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+};
+
+namespace detail {
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool is_digit(char c) { return '0' <= c && c <= '9'; }
+
+inline const char* skip_line(const char* p, const char* e) {
+    const char* q = static_cast<const char*>(memchr(p, '\n', e - p));
+    return q == nullptr ? e : q + 1;
+}
+
+inline const char* skip_space(const char* p, const char* e) {
+    while (p != e && is_space(*p)) ++p;
+    return p;
+}
+
+inline const char* skip_token(const char* p, const char* e) {
+    p = skip_space(p, e);
+    while (p != e && !is_space(*p)) ++p;
+    return p;
+}
+
+//  Parse the integer token at p, return the position after it or nullptr if the token is not an integer.
+inline const char* parse_int(const char* p, const char* e, long long& x) {
+    bool neg = false;
+    if (p != e && (*p == '-' || *p == '+')) neg = *p++ == '-';
+    if (p == e || !is_digit(*p)) return nullptr;
+    unsigned long long v = 0;
+    while (p != e && is_digit(*p))
+        v = v * 10 + (*p++ - '0');
+    if (p != e && !is_space(*p)) return nullptr;
+    x = neg ? -(long long)v : (long long)v;
+    return p;
+}
+
+//  Hand-written integer scanner over [p, e).
+//  Tokens that are not integers are skipped, '#' and '%' start a comment which runs to the end of the line.
+struct int_scanner {
+    const char* p;
+    const char* e;
+
+    bool next(long long& x) {
+        while (p != e) {
+            char c = *p;
+            if (is_space(c))
+                ++p;
+            else if (c == '#' || c == '%')
+                p = skip_line(p, e);
+            else if (const char* q = parse_int(p, e, x)) {
+                p = q;
+                return true;
+            }
+            else
+                while (p != e && !is_space(*p)) ++p;
+        }
+        return false;
+    }
+};
+
+//  Read an integer from the header, skipping any non-integer token.
+inline long long header_int(const char*& p, const char* e) {
+    int_scanner sc{ p, e };
+    long long x = 0;
+    sc.next(x);
+    p = sc.p;
+    return x;
+}
+
+//  Scan the integers of [b, e) in parallel.
+//  The range is split into t line-aligned chunks and the first pass counts the integers of each chunk.
+//  Then alloc(c) is called with the total count c and returns a limit l, and the second pass
+//  calls sink(i, x) for the i-th integer x of the range for all i < l.
+template<class Alloc, class Sink>
+void parallel_scan(const char* b, const char* e, unsigned t, Alloc&& alloc, Sink&& sink) {
+    std::size_t len = e - b;
+    t = std::max(1u, (unsigned)std::min<std::size_t>(t, len / 4096 + 1));
+    vector<const char*> cut(t + 1);
+    cut[0] = b;
+    cut[t] = e;
+    for (unsigned i = 1; i < t; ++i)
+        cut[i] = std::max(cut[i - 1], skip_line(b + len / t * i, e));
+
+    vector<std::size_t> cnt(t + 1, 0);
+    util::parallel_invoke(t, [&](unsigned i) {
+        int_scanner sc{ cut[i], cut[i + 1] };
+        long long x;
+        std::size_t c = 0;
+        while (sc.next(x)) ++c;
+        cnt[i + 1] = c;
+    });
+    for (unsigned i = 0; i < t; ++i)
+        cnt[i + 1] += cnt[i];
+
+    std::size_t limit = alloc(cnt[t]);
+    util::parallel_invoke(t, [&](unsigned i) {
+        int_scanner sc{ cut[i], cut[i + 1] };
+        long long x;
+        for (std::size_t j = cnt[i]; j < limit && sc.next(x); ++j)
+            sink(j, x);
+    });
+}
+
+}
+
+//  Memory-mapped multi-threaded reader for the formats above.
+//  The file is mapped into memory, the header is parsed serially and the body is
+//  parsed in parallel straight into a pre-sized edge vector.
+template<class Graph>
+pair<vertex_id_t<Graph>, vector<edge_t<Graph>>> read_graph_mmap(const string& path, const string& t, read_stats* stats = nullptr) {
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_weight_t<Graph> edge_weight;
+    typedef edge_t<Graph> edge_type;
+
+    util::profile::scope prof("read");
+    auto t_start = std::chrono::steady_clock::now();
+    util::mapped_file f;
+    if (!f.open(path))
+        return {};
+    const unsigned nt = util::num_threads();
+    const char* p = f.begin();
+    const char* e = f.end();
+
+    //  Number of integers per record, -1 for LO.
+    int k;
+    long long n = 0, m = -1;
+    if (t == "U" || t == "W") {
+        n = detail::header_int(p, e);
+        m = detail::header_int(p, e);
+        k = t == "U" ? 2 : 3;
+    }
+    else if (t == "DW" || t == "DU") {
+        p = detail::skip_token(p, e);
+        p = detail::skip_token(p, e);
+        n = detail::header_int(p, e);
+        m = detail::header_int(p, e);
+        k = 4;
+    }
+    else if (t == "SU") {
+        p = detail::skip_space(p, e);
+        while (p != e && *p == '#') {
+            const char* q = detail::skip_line(p, e);
+            string line(p, q);
+            size_t pn = line.find("Nodes:"), pm = line.find("Edges:");
+            if (pn != string::npos) n = atoll(line.c_str() + pn + 6);
+            if (pm != string::npos) m = atoll(line.c_str() + pm + 6);
+            p = detail::skip_space(q, e);
+        }
+        k = 2;
+    }
+    else if (t == "LU")
+        k = 2;
+    else if (t == "LO") {
+        n = detail::header_int(p, e);
+        m = n * n;
+        k = -1;
+    }
+    else
+        return {};
+
+    //  Number of records, bounded by m when the header provides it.
+    vector<edge_type> es;
+    auto alloc = [&](std::size_t c) {
+        std::size_t r = k < 0 ? c : c / k;
+        if (m >= 0) r = std::min<std::size_t>(r, m);
+        es.resize(r);
+        return k < 0 ? r : r * k;
+    };
+
+    if (t == "U" || t == "SU" || t == "LU")
+        detail::parallel_scan(p, e, nt, alloc, [&](std::size_t i, long long x) {
+            edge_type& r = es[i >> 1];
+            if (i & 1) r.dst = x;
+            else r.src = x, r.weight = 1;
+        });
+    else if (t == "W")
+        detail::parallel_scan(p, e, nt, alloc, [&](std::size_t i, long long x) {
+            edge_type& r = es[i / 3];
+            switch (i % 3) {
+                case 0: r.src = x; break;
+                case 1: r.dst = x; break;
+                default: r.weight = x;
+            }
+        });
+    else if (t == "DW" || t == "DU") {
+        const bool weighted = t == "DW";
+        detail::parallel_scan(p, e, nt, alloc, [&](std::size_t i, long long x) {
+            edge_type& r = es[i >> 2];
+            switch (i & 3) {
+                case 0: r.src = x - 1; break;
+                case 1: r.dst = x - 1; break;
+                case 2: r.weight = weighted ? x : 1; break;
+                default: break;
+            }
+        });
+    }
+    else
+        detail::parallel_scan(p, e, nt, alloc, [&](std::size_t i, long long x) {
+            es[i] = edge_type(vertex_id(i / n), vertex_id(i % n), edge_weight(x));
+        });
+
+    if (t == "W")
+        es.erase(std::remove_if(es.begin(), es.end(), [](const edge_type& r) { return r.weight == 0; }), es.end());
+
+    vector<vertex_id> mx(nt, 0);
+    util::parallel_blocks(nt, es.size(), [&](unsigned i, std::size_t l, std::size_t r) {
+        vertex_id x = 0;
+        for (std::size_t j = l; j < r; ++j)
+            x = max(x, max(es[j].src, es[j].dst) + 1);
+        mx[i] = x;
+    });
+    for (vertex_id x : mx)
+        n = max<long long>(n, x);
+    util::profile::count("bytes", f.size());
+
+    if (stats) {
+        stats->bytes = f.size();
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        stats->threads = nt;
+    }
+    return { vertex_id(n), move(es) };
+}
+
+//  Load a graph in the binary format of static_graph::save without copying its arrays.
+template<class Graph>
+bool load_graph_bin(Graph& g, const string& path, read_stats* stats = nullptr) {
+    util::profile::scope prof("read");
+    auto t_start = std::chrono::steady_clock::now();
+    if (!g.load(path))
+        return false;
+    util::profile::count("bytes", sizeof(static_graph_file_header) +
+        g.num_edges() * (sizeof(typename Graph::in_value_type) + sizeof(typename Graph::out_value_type)) +
+        2 * (g.num_vertices() + 1) * sizeof(edge_id_t<Graph>));
+    if (stats) {
+        stats->bytes = sizeof(static_graph_file_header) +
+            g.num_edges() * (sizeof(typename Graph::in_value_type) + sizeof(typename Graph::out_value_type)) +
+            2 * (g.num_vertices() + 1) * sizeof(edge_id_t<Graph>);
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        stats->threads = 1;
+    }
+    return true;
+}
+
+//  Edge list of a binary graph file, ordered by source and then destination.
+template<class Graph>
+pair<vertex_id_t<Graph>, vector<edge_t<Graph>>> read_graph_bin(const string& path, read_stats* stats = nullptr) {
+    if constexpr (std::is_same<decltype(std::declval<Graph&>().load(path)), bool>::value) {
+        Graph g;
+        if (!load_graph_bin(g, path, stats))
+            return {};
+        return { g.num_vertices(), vector<edge_t<Graph>>(g.edges().begin(), g.edges().end()) };
+    }
+    else
+        return {};
+}
+
+//  Read a graph in the BVGraph format of WebGraph, path is the basename or the .graph file.
+//  Arcs are ordered by source and then destination, as written by ArcListASCIIGraph.
+template<class Graph>
+pair<vertex_id_t<Graph>, vector<edge_t<Graph>>> read_graph_bv(const string& path, read_stats* stats = nullptr) {
+    typedef vertex_id_t<Graph> vertex_id;
+    typedef edge_t<Graph> edge_type;
+
+    util::profile::scope prof("read");
+    auto t_start = std::chrono::steady_clock::now();
+    webgraph::bvgraph bv;
+    if (!bv.open(path))
+        return {};
+
+    //  Each thread collects its arcs, which are then concatenated in node order.
+    vector<vector<edge_type>> parts(util::num_threads());
+    unsigned nt = bv.for_each_node(util::num_threads(), [&](unsigned i, std::uint64_t x, const vector<std::uint64_t>& s) {
+        for (std::uint64_t y : s)
+            parts[i].emplace_back(vertex_id(x), vertex_id(y), 1);
+    });
+    vector<std::size_t> pos(nt + 1, 0);
+    for (unsigned i = 0; i < nt; ++i)
+        pos[i + 1] = pos[i] + parts[i].size();
+    vector<edge_type> es(pos[nt]);
+    util::parallel_invoke(nt, [&](unsigned i) {
+        std::copy(parts[i].begin(), parts[i].end(), es.begin() + pos[i]);
+        vector<edge_type>().swap(parts[i]);
+    });
+    if (es.size() != bv.num_arcs)
+        fprintf(stderr, "Warning: %zu arcs decoded from %s, %llu expected\n", es.size(), path.c_str(), (unsigned long long)bv.num_arcs);
+    util::profile::count("bytes", bv.size());
+
+    if (stats) {
+        stats->bytes = bv.size();
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        stats->threads = nt;
+    }
+    return { vertex_id(bv.num_nodes), move(es) };
+}
+
+//  Read a graph file with the memory-mapped reader.
+//  Type BIN is the binary format of static_graph::save, type BV is the BVGraph format.
+template<class Graph>
+pair<vertex_id_t<Graph>, vector<edge_t<Graph>>> read_graph_impl(const string& path, const string& t, read_stats* stats = nullptr) {
+    if (t == "BIN")
+        return read_graph_bin<Graph>(path, stats);
+    if (t == "BV")
+        return read_graph_bv<Graph>(path, stats);
+    return read_graph_mmap<Graph>(path, t, stats);
+}
+
 template<class Graph, class Fn>
 Graph read_graph(istream& is, const string& t, Fn fn) {
     auto res = read_graph_impl<Graph>(is, t);
@@ -0,0 +1,235 @@
+#ifndef GRAPH_PARTITIONED_HPP
+#define GRAPH_PARTITIONED_HPP
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <graph/common.hpp>
+#include <util/iterator_range.hpp>
+#include <util/pointer_proxy.hpp>
+
+namespace graph {
+
+//  A single copy of the arcs of a graph whose vertices are recursively partitioned in place.
+//  Vertices are kept at positions [0, n). Every part is a contiguous range of positions and is
+//  accessed through a view, which behaves like a graph whose vertex i is the vertex at
+//  position lo + i. Each vertex keeps its arcs inside the current part at the front of its
+//  adjacency lists, so splitting a part only permutes positions and arcs of that part.
+//  Views of disjoint parts can be split by different threads at the same time.
+template<class Graph>
+class partitioned_graph {
+public:
+    typedef vertex_id_t<Graph> vertex_id_type;
+    typedef edge_id_t<Graph> edge_id_type;
+    typedef edge_weight_t<Graph> edge_weight_type;
+    typedef edge_t<Graph> edge_type;
+
+    class view;
+
+private:
+    struct arc {
+        vertex_id_type v;       //  Other end, by original id
+        edge_weight_type w;
+    };
+
+    //  Vertex at a position, with the arcs inside its part
+    struct slot {
+        edge_id_type ob, oe, ib, ie;
+        vertex_id_type v;
+    };
+
+    vertex_id_type n;
+    vector<arc> oa, ia;
+    vector<slot> sl;
+    vector<vertex_id_type> pos;     //  Position of each vertex
+
+    template<bool Out>
+    class adjacency_iterator {
+        const partitioned_graph* pg;
+        const arc* p;
+        vertex_id_type lo, u;
+
+        friend class view;
+        adjacency_iterator(const partitioned_graph* pg_, const arc* p_, vertex_id_type lo_, vertex_id_type u_)
+            : pg(pg_), p(p_), lo(lo_), u(u_) {}
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef edge_type reference;
+        typedef util::pointer_proxy<edge_type> pointer;
+
+        adjacency_iterator() = default;
+
+        reference operator*() const {
+            vertex_id_type v = pg->pos[p->v] - lo;
+            return Out ? edge_type(u, v, p->w) : edge_type(v, u, p->w);
+        }
+        pointer operator->() const { return pointer(**this); }
+        adjacency_iterator& operator++() { ++p; return *this; }
+        adjacency_iterator operator++(int) { adjacency_iterator it = *this; ++p; return it; }
+        bool operator==(const adjacency_iterator& it) const { return p == it.p; }
+        bool operator!=(const adjacency_iterator& it) const { return p != it.p; }
+    };
+
+    class edge_iterator {
+        const partitioned_graph* pg;
+        vertex_id_type lo, hi, u;
+        edge_id_type i;
+
+        friend class view;
+        edge_iterator(const partitioned_graph* pg_, vertex_id_type lo_, vertex_id_type hi_, vertex_id_type u_)
+            : pg(pg_), lo(lo_), hi(hi_), u(u_), i(0) { skip(); }
+
+        void skip() {
+            while (lo + u < hi && pg->sl[lo + u].ob + i == pg->sl[lo + u].oe) {
+                ++u;
+                i = 0;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef edge_type reference;
+        typedef util::pointer_proxy<edge_type> pointer;
+
+        edge_iterator() = default;
+
+        reference operator*() const {
+            const arc& a = pg->oa[pg->sl[lo + u].ob + i];
+            return edge_type(u, pg->pos[a.v] - lo, a.w);
+        }
+        pointer operator->() const { return pointer(**this); }
+        edge_iterator& operator++() { ++i; skip(); return *this; }
+        edge_iterator operator++(int) { edge_iterator it = *this; ++*this; return it; }
+        bool operator==(const edge_iterator& it) const { return u == it.u && i == it.i; }
+        bool operator!=(const edge_iterator& it) const { return !(*this == it); }
+    };
+
+public:
+    //  Part of the positions [lo, hi) of a partitioned_graph, with the interface of a graph
+    class view {
+    public:
+        typedef partitioned_graph::vertex_id_type vertex_id_type;
+        typedef partitioned_graph::edge_id_type edge_id_type;
+        typedef partitioned_graph::edge_weight_type edge_weight_type;
+        typedef partitioned_graph::edge_type edge_type;
+        typedef edge_type out_edge_type;
+        typedef edge_type in_edge_type;
+        typedef adjacency_iterator<true> out_edge_iterator;
+        typedef adjacency_iterator<false> in_edge_iterator;
+        typedef util::iterator_range<out_edge_iterator> out_adjacency_container;
+        typedef util::iterator_range<in_edge_iterator> in_adjacency_container;
+        typedef util::iterator_range<edge_iterator> edge_container;
+
+    private:
+        const partitioned_graph* pg;
+        vertex_id_type lo, hi;
+
+        friend class partitioned_graph;
+
+    public:
+
+        view() : pg(nullptr), lo(0), hi(0) {}
+        view(const partitioned_graph* pg_, vertex_id_type lo_, vertex_id_type hi_) : pg(pg_), lo(lo_), hi(hi_) {}
+
+        vertex_id_type num_vertices() const { return hi - lo; }
+
+        edge_id_type num_edges() const {
+            edge_id_type m = 0;
+            for (vertex_id_type p = lo; p < hi; ++p)
+                m += pg->sl[p].oe - pg->sl[p].ob;
+            return m;
+        }
+
+        //  First position of the part
+        vertex_id_type offset() const { return lo; }
+
+        //  Vertex of the input graph
+        vertex_id_type original_id(vertex_id_type u) const { return pg->sl[lo + u].v; }
+
+        edge_id_type out_degree(vertex_id_type u) const { return pg->sl[lo + u].oe - pg->sl[lo + u].ob; }
+        edge_id_type in_degree(vertex_id_type u) const { return pg->sl[lo + u].ie - pg->sl[lo + u].ib; }
+
+        out_adjacency_container out_edges(vertex_id_type u) const {
+            const slot& s = pg->sl[lo + u];
+            const arc* a = pg->oa.data();
+            return { out_edge_iterator(pg, a + s.ob, lo, u), out_edge_iterator(pg, a + s.oe, lo, u) };
+        }
+
+        in_adjacency_container in_edges(vertex_id_type u) const {
+            const slot& s = pg->sl[lo + u];
+            const arc* a = pg->ia.data();
+            return { in_edge_iterator(pg, a + s.ib, lo, u), in_edge_iterator(pg, a + s.ie, lo, u) };
+        }
+
+        edge_container edges() const {
+            return { edge_iterator(pg, lo, hi, 0), edge_iterator(pg, lo, hi, hi - lo) };
+        }
+    };
+
+    explicit partitioned_graph(const Graph& g) : n(g.num_vertices()), pos(n) {
+        oa.reserve(g.num_edges());
+        ia.reserve(g.num_edges());
+        sl.resize(n);
+        for (vertex_id_type u = 0; u < n; ++u) {
+            slot& s = sl[u];
+            s.v = u;
+            pos[u] = u;
+            s.ob = oa.size();
+            for (const auto& e : g.out_edges(u))
+                oa.push_back({ e.dst, e.weight });
+            s.oe = oa.size();
+            s.ib = ia.size();
+            for (const auto& e : g.in_edges(u))
+                ia.push_back({ e.src, e.weight });
+            s.ie = ia.size();
+        }
+    }
+
+    partitioned_graph(const partitioned_graph&) = delete;
+    partitioned_graph& operator=(const partitioned_graph&) = delete;
+
+    view whole() const { return view(this, 0, n); }
+
+    //  Split x into one part for each color, in the order of the colors.
+    //  Vertices keep their relative order inside a part. x must not be used afterwards.
+    vector<view> split(const view& x, const coloring_result<view>& c) {
+        const vertex_id_type k = x.num_vertices(), lo = x.lo;
+        vector<vertex_id_type> start(c.first + 1, 0);
+        for (vertex_id_type i = 0; i < k; ++i)
+            ++start[c.second[i] + 1];
+        for (vertex_id_type i = 0; i < c.first; ++i)
+            start[i + 1] += start[i];
+        vector<view> res;
+        for (vertex_id_type i = 0; i < c.first; ++i)
+            res.emplace_back(this, lo + start[i], lo + start[i + 1]);
+
+        vector<slot> tmp(k);
+        for (vertex_id_type i = 0; i < k; ++i)
+            tmp[start[c.second[i]]++] = sl[lo + i];
+        for (vertex_id_type i = 0; i < k; ++i) {
+            sl[lo + i] = tmp[i];
+            pos[tmp[i].v] = lo + i;
+        }
+
+        //  Move the arcs inside the new part of each vertex to the front
+        for (const view& y : res)
+            for (vertex_id_type p = y.lo; p < y.hi; ++p) {
+                slot& s = sl[p];
+                auto inside = [&](const arc& a) { return y.lo <= pos[a.v] && pos[a.v] < y.hi; };
+                s.oe = std::partition(oa.begin() + s.ob, oa.begin() + s.oe, inside) - oa.begin();
+                s.ie = std::partition(ia.begin() + s.ib, ia.begin() + s.ie, inside) - ia.begin();
+            }
+        return res;
+    }
+};
+
+template<class Graph>
+using partition_view = typename partitioned_graph<Graph>::view;
+
+}
+
+#endif
@@ -1,9 +1,19 @@
 #ifndef GRAPH_STATIC_HPP
 #define GRAPH_STATIC_HPP
 
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <graph/common.hpp>
 #include <util/tagged_tuple.hpp>
 #include <util/histogram_map.hpp>
+#include <util/mapped_file.hpp>
+#include <util/parallel.hpp>
+#include <util/profile.hpp>
 
 namespace graph {
 
@@ -37,6 +47,34 @@ struct static_graph_traits {
 
 };
 
+//  Header of the binary graph format written by static_graph::save.
+//  It is followed by the in-edge offsets, in-edge values, out-edge offsets and
+//  out-edge values arrays, each at the given byte position, aligned to 64 bytes.
+//  Arrays are stored in host byte order exactly as static_graph holds them in memory,
+//  so a file can only be loaded by a static_graph with the same type sizes.
+struct static_graph_file_header {
+    static constexpr char magic_string[8] = {'F', 'A', 'S', 'C', 'S', 'R', '\0', '\0'};
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t byte_order_mark = 0x01020304;
+    static constexpr std::uint64_t alignment = 64;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t vertex_id_size;
+    std::uint32_t edge_id_size;
+    std::uint32_t in_edge_size;
+    std::uint32_t out_edge_size;
+    std::uint32_t sorted;
+    std::uint32_t reserved;
+    std::uint64_t n;
+    std::uint64_t m;
+    std::uint64_t in_offsets_pos;
+    std::uint64_t in_values_pos;
+    std::uint64_t out_offsets_pos;
+    std::uint64_t out_values_pos;
+};
+
 template<class VertexSizeType, class EdgeSizeType, class EdgeWeightType, bool SortedEdges = true>
 class static_graph {
 public:
@@ -57,6 +95,10 @@ public:
     typedef typename out_edge_container::value_type out_edge_type;
     typedef typename in_edge_container::value_type in_edge_type;
 
+    //  Stored part of an edge, without the key of its adjacency list
+    typedef typename out_edge_container::partial_value_type out_value_type;
+    typedef typename in_edge_container::partial_value_type in_value_type;
+
     typedef typename out_edge_container::slice out_adjacency_container;
     typedef typename in_edge_container::slice in_adjacency_container;
 
@@ -68,6 +110,126 @@ private:
     in_edge_container m_in_edges;
     out_edge_container m_out_edges;
 
+    //  Inputs with fewer edges are built by a single thread.
+    static constexpr edge_id_type parallel_build_threshold = 1 << 16;
+
+    template<class FwdIt>
+    void assign_edges(FwdIt first, FwdIt last, std::forward_iterator_tag) {
+        m_in_edges.assign(m_n, first, last, util::elements_are_unsorted);
+        m_out_edges.assign(m_n, first, last, util::elements_are_unsorted);
+    }
+
+    //  Two-pass counting sort into both adjacency arrays at once.
+    //  Each thread counts the degrees of a contiguous block of the input, and then
+    //  places its edges from the back of each adjacency list, so that every list holds
+    //  its edges in reverse input order, as histogram_map::assign does.
+    //  With SortedEdges each list is then stably sorted by its secondary key.
+    template<class RndIt>
+    void assign_edges(RndIt first, RndIt last, std::random_access_iterator_tag) {
+        const edge_id_type m = last - first;
+        const vertex_id_type n = m_n;
+        m_in_edges.allocate(n, m);
+        m_out_edges.allocate(n, m);
+        if (n == 0) return;
+
+        //  Per-thread histograms take 2tn counters, keep them within the size of the input.
+        unsigned t = m < parallel_build_threshold ? 1 : util::num_threads();
+        t = std::max<edge_id_type>(1, std::min<edge_id_type>(t, m / n));
+        vector<vector<edge_id_type>> in_cnt(t), out_cnt(t);
+        util::parallel_blocks(t, m, [&](unsigned i, edge_id_type l, edge_id_type r) {
+            in_cnt[i].assign(n, 0);
+            out_cnt[i].assign(n, 0);
+            for (edge_id_type j = l; j < r; ++j) {
+                in_cnt[i][first[j].dst]++;
+                out_cnt[i][first[j].src]++;
+            }
+        });
+
+        //  Offsets by a blocked prefix sum over the vertices, and the position
+        //  after the last edge of each thread in each list.
+        edge_id_type* in_off = m_in_edges.offset_data();
+        edge_id_type* out_off = m_out_edges.offset_data();
+        unsigned tv = std::max<vertex_id_type>(1, std::min<vertex_id_type>(util::num_threads(), n / 4096));
+        vector<edge_id_type> in_sum(tv + 1, 0), out_sum(tv + 1, 0);
+        util::parallel_blocks(tv, n, [&](unsigned b, vertex_id_type l, vertex_id_type r) {
+            for (vertex_id_type v = l; v < r; ++v) {
+                edge_id_type di = 0, dout = 0;
+                for (unsigned i = 0; i < t; ++i) {
+                    di += in_cnt[i][v];
+                    dout += out_cnt[i][v];
+                }
+                in_off[v] = di;
+                out_off[v] = dout;
+                in_sum[b + 1] += di;
+                out_sum[b + 1] += dout;
+            }
+        });
+        for (unsigned b = 0; b < tv; ++b) {
+            in_sum[b + 1] += in_sum[b];
+            out_sum[b + 1] += out_sum[b];
+        }
+        util::parallel_blocks(tv, n, [&](unsigned b, vertex_id_type l, vertex_id_type r) {
+            auto place = [&](edge_id_type* off, vector<vector<edge_id_type>>& cnt, edge_id_type s, vertex_id_type v) {
+                edge_id_type end = s + off[v], e = end;
+                off[v] = s;
+                for (unsigned i = 0; i < t; ++i) {
+                    edge_id_type c = cnt[i][v];
+                    cnt[i][v] = e;
+                    e -= c;
+                }
+                return end;
+            };
+            edge_id_type si = in_sum[b], so = out_sum[b];
+            for (vertex_id_type v = l; v < r; ++v) {
+                si = place(in_off, in_cnt, si, v);
+                so = place(out_off, out_cnt, so, v);
+            }
+        });
+
+        in_value_type* in_val = m_in_edges.value_data();
+        out_value_type* out_val = m_out_edges.value_data();
+        util::parallel_blocks(t, m, [&](unsigned i, edge_id_type l, edge_id_type r) {
+            vector<edge_id_type>& ic = in_cnt[i];
+            vector<edge_id_type>& oc = out_cnt[i];
+            for (edge_id_type j = l; j < r; ++j) {
+                new (in_val + --ic[first[j].dst]) in_value_type(first[j]);
+                new (out_val + --oc[first[j].src]) out_value_type(first[j]);
+            }
+        });
+
+        if (SortedEdges) {
+            sort_lists(in_off, in_val, [](const in_value_type& x, const in_value_type& y) { return x.get(src<>()) < y.get(src<>()); });
+            sort_lists(out_off, out_val, [](const out_value_type& x, const out_value_type& y) { return x.get(dst<>()) < y.get(dst<>()); });
+        }
+    }
+
+    //  Stable sort of each adjacency list, in parallel over ranges of vertices with equally many edges.
+    template<class T, class Less>
+    void sort_lists(const edge_id_type* off, T* val, Less less) {
+        const vertex_id_type n = m_n;
+        const edge_id_type m = off[n];
+        unsigned t = m < parallel_build_threshold ? 1 : util::num_threads();
+        util::parallel_invoke(t, [&](unsigned i) {
+            vertex_id_type l = std::lower_bound(off, off + n, m / t * i + std::min<edge_id_type>(i, m % t)) - off;
+            vertex_id_type r = i + 1 == t ? n : std::lower_bound(off, off + n, m / t * (i + 1) + std::min<edge_id_type>(i + 1, m % t)) - off;
+            for (vertex_id_type v = l; v < r; ++v) {
+                T* b = val + off[v];
+                T* e = val + off[v + 1];
+                if (e - b <= 16) {
+                    for (T* p = b + 1; p < e; ++p) {
+                        T x = *p;
+                        T* q = p;
+                        for (; q != b && less(x, q[-1]); --q)
+                            *q = q[-1];
+                        *q = x;
+                    }
+                }
+                else
+                    std::stable_sort(b, e, less);
+            }
+        });
+    }
+
 public:
     static_graph() : m_n(0) {}
     static_graph(const this_type&) = default;
@@ -79,11 +241,15 @@ public:
     ~static_graph() = default;
 
     template<class FwdIt>
-    static_graph(vertex_id_type n, FwdIt begin_, FwdIt end_) :
-        m_n(n),
-        m_in_edges(n, begin_, end_, util::elements_are_unsorted),
-        m_out_edges(n, begin_, end_, util::elements_are_unsorted)
-        {}
+    static_graph(vertex_id_type n, FwdIt begin_, FwdIt end_) : m_n(n) {
+        util::profile::scope prof("build");
+        assign_edges(begin_, end_, typename std::iterator_traits<FwdIt>::iterator_category());
+        if (util::profile::is_enabled()) {
+            util::profile::count("arcs", num_edges());
+            util::profile::count("bytes", 2 * (std::int64_t(n) + 1) * sizeof(edge_id_type) +
+                std::int64_t(num_edges()) * (sizeof(in_value_type) + sizeof(out_value_type)));
+        }
+    }
 
     vertex_id_type num_vertices() const { return m_n; }
 
@@ -101,6 +267,115 @@ public:
         return m_out_edges[v];
     }
 
+    //  Write the graph in the binary format, see static_graph_file_header.
+    bool save(const std::string& path) const {
+        typedef static_graph_file_header header_type;
+        static_assert(std::is_trivially_copyable<in_value_type>::value &&
+            std::is_trivially_copyable<out_value_type>::value, "edges must be trivially copyable");
+
+        header_type h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, header_type::magic_string, sizeof(h.magic));
+        h.version = header_type::current_version;
+        h.byte_order = header_type::byte_order_mark;
+        h.vertex_id_size = sizeof(vertex_id_type);
+        h.edge_id_size = sizeof(edge_id_type);
+        h.in_edge_size = sizeof(in_value_type);
+        h.out_edge_size = sizeof(out_value_type);
+        h.sorted = SortedEdges;
+        h.n = m_n;
+        h.m = num_edges();
+
+        std::uint64_t offsets_bytes = m_n == 0 ? 0 : (h.n + 1) * sizeof(edge_id_type);
+        std::uint64_t pos = sizeof(h);
+        auto place = [&](std::uint64_t bytes) {
+            pos = (pos + header_type::alignment - 1) / header_type::alignment * header_type::alignment;
+            std::uint64_t r = pos;
+            pos += bytes;
+            return r;
+        };
+        h.in_offsets_pos = place(offsets_bytes);
+        h.in_values_pos = place(h.m * sizeof(in_value_type));
+        h.out_offsets_pos = place(offsets_bytes);
+        h.out_values_pos = place(h.m * sizeof(out_value_type));
+
+        FILE* f = fopen(path.c_str(), "wb");
+        if (f == nullptr) return false;
+        std::uint64_t written = 0;
+        bool ok = true;
+        auto put = [&](std::uint64_t at, const void* p, std::uint64_t bytes) {
+            static const char zeros[header_type::alignment] = {};
+            if (ok && at > written)
+                ok = fwrite(zeros, 1, at - written, f) == at - written;
+            if (ok && bytes != 0)
+                ok = fwrite(p, 1, bytes, f) == bytes;
+            written = at + bytes;
+        };
+        //  Values are copied field by field into a zeroed buffer, so that
+        //  padding bytes are written as zeros and the output is deterministic.
+        auto put_values = [&](std::uint64_t at, const auto* p) {
+            typedef std::remove_const_t<std::remove_pointer_t<decltype(p)>> value_type;
+            const std::uint64_t chunk = 1 << 14;
+            std::unique_ptr<value_type[]> buf(new value_type[chunk]);
+            for (std::uint64_t i = 0; i < h.m; i += chunk) {
+                std::uint64_t c = std::min(chunk, h.m - i);
+                std::memset(static_cast<void*>(buf.get()), 0, c * sizeof(value_type));
+                for (std::uint64_t j = 0; j < c; ++j)
+                    buf[j].assign(p[i + j], util::tag_rebinder<void, void, void>());
+                put(at + i * sizeof(value_type), buf.get(), c * sizeof(value_type));
+            }
+        };
+        put(0, &h, sizeof(h));
+        put(h.in_offsets_pos, m_in_edges.offset_data(), offsets_bytes);
+        put_values(h.in_values_pos, m_in_edges.value_data());
+        put(h.out_offsets_pos, m_out_edges.offset_data(), offsets_bytes);
+        put_values(h.out_values_pos, m_out_edges.value_data());
+        return fclose(f) == 0 && ok;
+    }
+
+    //  Load a graph written by save. The file is mapped copy-on-write and its arrays are used
+    //  in place, so the graph may be modified without changing the file. Returns false and leaves the graph unchanged if the file can not be used.
+    bool load(const std::string& path) {
+        typedef static_graph_file_header header_type;
+
+        auto file = std::make_shared<util::mapped_file>();
+        if (!file->open(path, true) || file->size() < sizeof(header_type)) return false;
+        header_type h;
+        std::memcpy(&h, file->data(), sizeof(h));
+        if (std::memcmp(h.magic, header_type::magic_string, sizeof(h.magic)) != 0 ||
+            h.version != header_type::current_version ||
+            h.byte_order != header_type::byte_order_mark ||
+            h.vertex_id_size != sizeof(vertex_id_type) ||
+            h.edge_id_size != sizeof(edge_id_type) ||
+            h.in_edge_size != sizeof(in_value_type) ||
+            h.out_edge_size != sizeof(out_value_type) ||
+            h.sorted < SortedEdges)
+            return false;
+
+        std::uint64_t offsets_bytes = h.n == 0 ? 0 : (h.n + 1) * sizeof(edge_id_type);
+        auto fits = [&](std::uint64_t at, std::uint64_t bytes) {
+            return at % header_type::alignment == 0 && at <= file->size() && bytes <= file->size() - at;
+        };
+        if (!fits(h.in_offsets_pos, offsets_bytes) ||
+            !fits(h.in_values_pos, h.m * sizeof(in_value_type)) ||
+            !fits(h.out_offsets_pos, offsets_bytes) ||
+            !fits(h.out_values_pos, h.m * sizeof(out_value_type)))
+            return false;
+
+        char* base = file->mutable_data();
+        auto in_offsets = reinterpret_cast<edge_id_type*>(base + h.in_offsets_pos);
+        auto out_offsets = reinterpret_cast<edge_id_type*>(base + h.out_offsets_pos);
+        if (h.n == 0 ? h.m != 0 : ((std::uint64_t)in_offsets[h.n] != h.m || (std::uint64_t)out_offsets[h.n] != h.m))
+            return false;
+
+        m_n = h.n;
+        m_in_edges.adopt(h.n, in_offsets,
+            reinterpret_cast<in_value_type*>(base + h.in_values_pos), file);
+        m_out_edges.adopt(h.n, out_offsets,
+            reinterpret_cast<out_value_type*>(base + h.out_values_pos), file);
+        return true;
+    }
+
 };
 
 
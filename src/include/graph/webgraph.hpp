@@ -0,0 +1,366 @@
+#ifndef GRAPH_WEBGRAPH_HPP
+#define GRAPH_WEBGRAPH_HPP
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <util/mapped_file.hpp>
+#include <util/parallel.hpp>
+
+namespace graph {
+
+namespace webgraph {
+
+using std::string;
+using std::vector;
+using std::uint64_t;
+
+//  Big-endian bit stream over a byte array, as written by the dsiutils OutputBitStream.
+class bit_reader {
+    const unsigned char* p;
+    uint64_t nbytes;
+    uint64_t pos;
+
+    //  The next 64 - (pos & 7) bits starting at pos, left aligned, zero padded past the end.
+    uint64_t peek() const {
+        uint64_t b = pos >> 3, w = 0;
+        if (b + 8 <= nbytes) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            std::memcpy(&w, p + b, 8);
+            w = __builtin_bswap64(w);
+#else
+            for (int i = 0; i < 8; ++i)
+                w = w << 8 | p[b + i];
+#endif
+        }
+        else {
+            for (int i = 0; i < 8; ++i)
+                w = w << 8 | (b + i < nbytes ? p[b + i] : 0);
+        }
+        return w << (pos & 7);
+    }
+
+public:
+    bit_reader(const char* p_, uint64_t nbytes_, uint64_t pos_ = 0) :
+        p(reinterpret_cast<const unsigned char*>(p_)), nbytes(nbytes_), pos(pos_) {}
+
+    uint64_t position() const { return pos; }
+
+    bool eof() const { return pos >= nbytes * 8; }
+
+    uint64_t read_int(int k) {
+        if (k == 0) return 0;
+        if (k > 56) {
+            uint64_t h = read_int(k - 32);
+            return h << 32 | read_int(32);
+        }
+        uint64_t x = peek() >> (64 - k);
+        pos += k;
+        return x;
+    }
+
+    //  Number of zeros before the next one.
+    uint64_t read_unary() {
+        uint64_t c = 0;
+        for (;;) {
+            uint64_t w = peek();
+            int valid = 64 - (pos & 7);
+            if (w != 0) {
+                int z = __builtin_clzll(w);
+                pos += z + 1;
+                return c + z;
+            }
+            pos += valid;
+            c += valid;
+            if (eof()) return c;
+        }
+    }
+
+    uint64_t read_gamma() {
+        int h = read_unary();
+        return ((uint64_t(1) << h) | read_int(h)) - 1;
+    }
+
+    uint64_t read_delta() {
+        int h = read_gamma();
+        return ((uint64_t(1) << h) | read_int(h)) - 1;
+    }
+
+    uint64_t read_zeta(int k) {
+        int h = read_unary();
+        uint64_t left = uint64_t(1) << (h * k);
+        uint64_t m = read_int(h * k + k - 1);
+        if (m < left) return m + left - 1;
+        return (m << 1) + read_int(1) - 1;
+    }
+};
+
+//  Coding of a component of the format, see BVGraph compression flags.
+enum class coding { gamma, delta, zeta, unary };
+
+inline int64_t nat2int(uint64_t x) {
+    return (x & 1) ? -int64_t((x + 1) >> 1) : int64_t(x >> 1);
+}
+
+//  Reader of graphs in the BVGraph format of WebGraph
+//  (https://webgraph.di.unimi.it/), given by a basename with the files
+//      basename.properties
+//      basename.graph
+//      basename.offsets (optional)
+//  The successor lists are decoded in parallel when the offsets file exists,
+//  and sequentially otherwise.
+class bvgraph {
+public:
+    uint64_t num_nodes = 0;
+    uint64_t num_arcs = 0;
+
+private:
+    int window_size = 7;
+    int min_interval_length = 4;
+    int zeta_k = 3;
+    coding outdegree_coding = coding::gamma;
+    coding block_coding = coding::gamma;
+    coding residual_coding = coding::zeta;
+    coding reference_coding = coding::unary;
+    coding block_count_coding = coding::gamma;
+    coding offset_coding = coding::gamma;
+
+    util::mapped_file graph_file;
+    vector<uint64_t> offsets;
+
+    //  Scratch space of one decoding thread, one entry per reference depth.
+    struct scratch {
+        vector<uint64_t> blocks, lefts, lens, extra, merged;
+        std::deque<vector<uint64_t>> refs;
+    };
+
+    uint64_t read(bit_reader& br, coding c) const {
+        switch (c) {
+            case coding::gamma: return br.read_gamma();
+            case coding::delta: return br.read_delta();
+            case coding::zeta: return br.read_zeta(zeta_k);
+            default: return br.read_unary();
+        }
+    }
+
+    static bool parse_coding(const string& s, coding& c) {
+        if (s == "GAMMA") c = coding::gamma;
+        else if (s == "DELTA") c = coding::delta;
+        else if (s == "ZETA") c = coding::zeta;
+        else if (s == "UNARY") c = coding::unary;
+        else return false;
+        return true;
+    }
+
+    bool parse_flags(const string& flags) {
+        size_t i = 0;
+        while (i < flags.size()) {
+            size_t j = flags.find('|', i);
+            if (j == string::npos) j = flags.size();
+            string f = flags.substr(i, j - i);
+            f.erase(std::remove_if(f.begin(), f.end(), [](char c) { return c == ' ' || c == '\t' || c == '\r'; }), f.end());
+            i = j + 1;
+            if (f.empty()) continue;
+            size_t k = f.rfind('_');
+            if (k == string::npos) return false;
+            string what = f.substr(0, k), how = f.substr(k + 1);
+            coding* c;
+            if (what == "OUTDEGREES") c = &outdegree_coding;
+            else if (what == "BLOCKS") c = &block_coding;
+            else if (what == "RESIDUALS") c = &residual_coding;
+            else if (what == "REFERENCES") c = &reference_coding;
+            else if (what == "BLOCK_COUNT") c = &block_count_coding;
+            else if (what == "OFFSETS") c = &offset_coding;
+            else return false;
+            if (!parse_coding(how, *c)) return false;
+        }
+        return true;
+    }
+
+    //  Decode the successors of x from the current position of br into out.
+    //  lo is the first node whose successor list can be taken from the window.
+    void decode(bit_reader& br, uint64_t x, uint64_t lo, vector<vector<uint64_t>>& window,
+        vector<uint64_t>& out, scratch& s, int depth) const {
+        out.clear();
+        uint64_t d = read(br, outdegree_coding);
+        if (d == 0) return;
+
+        uint64_t ref = window_size > 0 ? read(br, reference_coding) : 0;
+        vector<uint64_t>& copied = s.merged;
+        if (ref > 0) {
+            uint64_t y = x - ref;
+            const vector<uint64_t>* rl;
+            if (y >= lo)
+                rl = &window[y % window.size()];
+            else {
+                //  The referenced list lies before this chunk, decode it on its own.
+                if ((int)s.refs.size() <= depth) s.refs.resize(depth + 1);
+                bit_reader rb(graph_file.data(), graph_file.size(), offsets[y]);
+                decode(rb, y, y, window, s.refs[depth], s, depth + 1);
+                rl = &s.refs[depth];
+            }
+            copied.clear();
+            uint64_t bc = read(br, block_count_coding);
+            s.blocks.resize(bc);
+            for (uint64_t i = 0; i < bc; ++i)
+                s.blocks[i] = read(br, block_coding) + (i == 0 ? 0 : 1);
+            //  Blocks alternately copy and skip successors of the reference,
+            //  the rest is copied if the number of blocks is even.
+            uint64_t j = 0;
+            for (uint64_t i = 0; i < bc; ++i) {
+                uint64_t e = std::min<uint64_t>(j + s.blocks[i], rl->size());
+                if (i % 2 == 0)
+                    copied.insert(copied.end(), rl->begin() + j, rl->begin() + e);
+                j = e;
+            }
+            if (bc % 2 == 0 && j < rl->size())
+                copied.insert(copied.end(), rl->begin() + j, rl->end());
+        }
+        else
+            copied.clear();
+
+        uint64_t extra_count = d - copied.size();
+        vector<uint64_t>& extra = s.extra;
+        extra.clear();
+        if (extra_count > 0) {
+            uint64_t ic = min_interval_length != 0 ? br.read_gamma() : 0;
+            if (ic != 0) {
+                s.lefts.resize(ic);
+                s.lens.resize(ic);
+                uint64_t prev = x + nat2int(br.read_gamma());
+                for (uint64_t i = 0; i < ic; ++i) {
+                    if (i != 0) prev += br.read_gamma() + 1;
+                    s.lefts[i] = prev;
+                    s.lens[i] = br.read_gamma() + min_interval_length;
+                    prev += s.lens[i];
+                    extra_count -= s.lens[i];
+                }
+                for (uint64_t i = 0; i < ic; ++i)
+                    for (uint64_t k = 0; k < s.lens[i]; ++k)
+                        extra.push_back(s.lefts[i] + k);
+            }
+            if (extra_count > 0) {
+                size_t b = extra.size();
+                uint64_t prev = x + nat2int(read(br, residual_coding));
+                extra.push_back(prev);
+                for (uint64_t i = 1; i < extra_count; ++i)
+                    extra.push_back(prev += read(br, residual_coding) + 1);
+                std::inplace_merge(extra.begin(), extra.begin() + b, extra.end());
+            }
+        }
+
+        out.resize(copied.size() + extra.size());
+        std::merge(copied.begin(), copied.end(), extra.begin(), extra.end(), out.begin());
+    }
+
+    //  Decode the nodes [l, r), whose lists start at bit position pos, and call fn(x, successors).
+    template<class Fn>
+    void decode_range(uint64_t l, uint64_t r, uint64_t pos, Fn&& fn) const {
+        bit_reader br(graph_file.data(), graph_file.size(), pos);
+        vector<vector<uint64_t>> window(window_size + 1);
+        scratch s;
+        for (uint64_t x = l; x < r; ++x) {
+            vector<uint64_t>& out = window[x % window.size()];
+            decode(br, x, l, window, out, s, 0);
+            fn(x, out);
+        }
+    }
+
+    bool read_properties(const string& path) {
+        std::ifstream is(path);
+        if (!is) return false;
+        std::map<string, string> p;
+        string line;
+        while (std::getline(is, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            size_t k = line.find('=');
+            if (k == string::npos) continue;
+            string v = line.substr(k + 1);
+            while (!v.empty() && (v.back() == '\r' || v.back() == ' ')) v.pop_back();
+            p[line.substr(0, k)] = v;
+        }
+        auto get = [&](const char* key, long long def) {
+            auto it = p.find(key);
+            return it == p.end() || it->second.empty() ? def : atoll(it->second.c_str());
+        };
+        if (p.count("graphclass") && p["graphclass"].find("BVGraph") == string::npos)
+            return false;
+        if (get("version", 0) != 0)
+            return false;
+        num_nodes = get("nodes", -1);
+        num_arcs = get("arcs", -1);
+        if (!p.count("nodes") || !p.count("arcs"))
+            return false;
+        window_size = get("windowsize", 7);
+        min_interval_length = get("minintervallength", 4);
+        zeta_k = get("zetak", 3);
+        return parse_flags(p.count("compressionflags") ? p["compressionflags"] : "");
+    }
+
+    bool read_offsets(const string& path) {
+        util::mapped_file f;
+        if (!f.open(path) || f.size() == 0) return false;
+        bit_reader br(f.data(), f.size());
+        offsets.resize(num_nodes + 1);
+        uint64_t o = 0;
+        for (uint64_t i = 0; i <= num_nodes; ++i) {
+            if (br.eof()) {
+                offsets.clear();
+                return false;
+            }
+            offsets[i] = o += read(br, offset_coding);
+        }
+        return true;
+    }
+
+public:
+    //  Open basename.properties and basename.graph, and basename.offsets if it exists.
+    //  A trailing ".graph" of the given name is ignored.
+    bool open(string basename) {
+        const string ext = ".graph";
+        if (basename.size() > ext.size() && basename.compare(basename.size() - ext.size(), ext.size(), ext) == 0)
+            basename.erase(basename.size() - ext.size());
+        if (!read_properties(basename + ".properties") || !graph_file.open(basename + ".graph"))
+            return false;
+        read_offsets(basename + ".offsets");
+        return true;
+    }
+
+    //  Size of the compressed graph in bytes
+    std::size_t size() const { return graph_file.size(); }
+
+    bool has_offsets() const { return !offsets.empty(); }
+
+    //  Call fn(i, x, successors) for every node x on t threads, where i is the thread
+    //  that decodes x. Each thread gets a contiguous range of nodes, in increasing order.
+    //  Returns the number of threads used.
+    template<class Fn>
+    unsigned for_each_node(unsigned t, Fn&& fn) const {
+        if (!has_offsets() || num_nodes == 0) {
+            decode_range(0, num_nodes, 0, [&](uint64_t x, const vector<uint64_t>& s) { fn(0u, x, s); });
+            return 1;
+        }
+        //  Split by compressed size, which follows the decoding work closely.
+        t = std::max(1u, std::min<unsigned>(t, num_nodes));
+        vector<uint64_t> bounds(t + 1, num_nodes);
+        bounds[0] = 0;
+        for (unsigned i = 1; i < t; ++i)
+            bounds[i] = std::lower_bound(offsets.begin(), offsets.end() - 1, offsets.back() / t * i) - offsets.begin();
+        util::parallel_invoke(t, [&](unsigned i) {
+            decode_range(bounds[i], bounds[i + 1], offsets[bounds[i]],
+                [&](uint64_t x, const vector<uint64_t>& s) { fn(i, x, s); });
+        });
+        return t;
+    }
+};
+
+}
+
+}
+
+#endif
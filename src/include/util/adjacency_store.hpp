@@ -0,0 +1,352 @@
+#ifndef UTIL_ADJACENCY_STORE_HPP
+#define UTIL_ADJACENCY_STORE_HPP
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <type_traits>
+
+namespace util {
+
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+using std::pair;
+using std::unique_ptr;
+using std::is_integral_v;
+
+//  Adjacency maps u -> { v -> w } of a dynamic graph with vertices [0, n).
+//  The map of a vertex is laid out as a __gnu_pbds::gp_hash_table<K, V> with the default
+//  policies would lay it out, so that its arcs are iterated in the same order: an open-addressing
+//  table of 2^k >= 8 slots, indexed by the key modulo its size with linear probing, where erased
+//  arcs leave a tombstone, and which doubles when it is half full and halves when it is 1/8 full.
+//  A table of 8 slots holds at most 3 arcs, which are kept inline sorted by slot. Larger tables
+//  are allocated from a pool shared by all vertices and recycled by size.
+//  Tables never move once allocated, so iterators of a vertex stay valid until the arcs
+//  of that vertex are modified. The keys std::numeric_limits<K>::max() and max() - 1 are reserved.
+//  Different threads may modify the maps of disjoint sets of vertices at the same time.
+template<class K, class V>
+class adjacency_store {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef uint32_t size_type;
+
+    static_assert(is_integral_v<K>, "Key type must be integral.");
+
+    struct value_type {
+        K first;
+        V second;
+
+        operator pair<K, V>() const { return { first, second }; }
+    };
+
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename adjacency_store::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef value_type& reference;
+        typedef value_type* pointer;
+
+    private:
+        pointer p, e;
+
+        void skip() {
+            while (p != e && p->first >= erased_key) ++p;
+        }
+
+        friend class adjacency_store;
+        iterator(pointer p_, pointer e_) : p(p_), e(e_) { skip(); }
+
+    public:
+        iterator() : p(nullptr), e(nullptr) {}
+
+        reference operator*() const { return *p; }
+        pointer operator->() const { return p; }
+        iterator& operator++() { ++p; skip(); return *this; }
+        iterator operator++(int) { iterator it = *this; ++*this; return it; }
+        bool operator==(const iterator& it) const { return p == it.p; }
+        bool operator!=(const iterator& it) const { return p != it.p; }
+    };
+
+    typedef iterator const_iterator;
+
+private:
+    static constexpr K empty_key = std::numeric_limits<K>::max();
+    static constexpr K erased_key = empty_key - 1;
+    static constexpr size_t chunk_size = size_t(1) << 16;
+
+    //  Size of the smallest table, and the most arcs it holds
+    static constexpr size_type min_size = 8;
+    static constexpr size_type inline_size = min_size / 2 - 1;
+
+    //  A table grows on the next insertion once it has this many arcs
+    static constexpr size_type grow_size(size_type c) { return c / 2 - 1; }
+    //  and shrinks once it has no more than this many
+    static constexpr size_type shrink_size(size_type c) { return c / 8; }
+
+    struct node {
+        size_type n;                //  Number of arcs
+        size_type c;                //  Size of the table, min_size if the arcs are inline
+        bool resize;                //  Resize before the next insertion
+        std::uint8_t erased;        //  Inline: bit s is set if slot s holds a tombstone
+        std::uint8_t pos[inline_size];  //  Inline: slot of a[i]
+        union {
+            value_type a[inline_size];  //  Inline arcs, in the order of their slots
+            value_type* t;
+        };
+
+        node() : n(0), c(min_size), resize(true), erased(0), t(nullptr) {}
+
+        value_type* data() { return c == min_size ? a : t; }
+        value_type* data_end() { return c == min_size ? a + n : t + c; }
+    };
+
+    vector<node> nodes;
+
+    //  Pool of tables. free_tables[i] holds released tables of capacity 2^i.
+    vector<unique_ptr<value_type[]>> chunks;
+    size_t pool_size = 0;
+    value_type* chunk_ptr = nullptr;
+    size_t chunk_left = 0;
+    vector<vector<value_type*>> free_tables;
+    std::mutex pool_lock;
+
+    static size_t slot(K k, size_type c) {
+        return size_t(k) & (c - 1);
+    }
+
+    value_type* allocate(size_type c) {
+        std::lock_guard<std::mutex> l(pool_lock);
+        size_t b = __builtin_ctz(c);
+        if (free_tables.size() <= b)
+            free_tables.resize(b + 1);
+        value_type* t;
+        if (!free_tables[b].empty()) {
+            t = free_tables[b].back();
+            free_tables[b].pop_back();
+        }
+        else if (c >= chunk_size / 4) {
+            chunks.emplace_back(new value_type[c]);
+            pool_size += c;
+            t = chunks.back().get();
+        }
+        else {
+            if (chunk_left < c) {
+                chunks.emplace_back(new value_type[chunk_size]);
+                pool_size += chunk_size;
+                chunk_ptr = chunks.back().get();
+                chunk_left = chunk_size;
+            }
+            t = chunk_ptr;
+            chunk_ptr += c;
+            chunk_left -= c;
+        }
+        for (size_type i = 0; i < c; ++i)
+            t[i].first = empty_key;
+        return t;
+    }
+
+    void release(value_type* t, size_type c) {
+        std::lock_guard<std::mutex> l(pool_lock);
+        free_tables[__builtin_ctz(c)].push_back(t);
+    }
+
+    //  Bit s is set if slot s of an inline table holds an arc
+    static unsigned inline_used(const node& x) {
+        unsigned r = 0;
+        for (size_type i = 0; i < x.n; ++i)
+            r |= 1u << x.pos[i];
+        return r;
+    }
+
+    value_type* find_in(node& x, K k) {
+        if (x.c == min_size) {
+            for (size_type i = 0; i < x.n; ++i)
+                if (x.a[i].first == k) return x.a + i;
+            return nullptr;
+        }
+        for (size_type i = 0, s = slot(k, x.c); i < x.c; ++i, s = (s + 1) & (x.c - 1)) {
+            if (x.t[s].first == k) return x.t + s;
+            if (x.t[s].first == empty_key) return nullptr;
+        }
+        return nullptr;
+    }
+
+    //  Slot for a key that is not in x: the first tombstone before the first empty slot
+    //  along its probe sequence, or that empty slot
+    size_type insert_slot(node& x, K k) {
+        size_type r = x.c;
+        if (x.c == min_size) {
+            const unsigned used = inline_used(x);
+            for (size_type i = 0, s = slot(k, x.c); i < x.c; ++i, s = (s + 1) & (x.c - 1)) {
+                if (x.erased >> s & 1) {
+                    if (r == x.c) r = s;
+                }
+                else if (!(used >> s & 1))
+                    return r == x.c ? s : r;
+            }
+            return r;
+        }
+        for (size_type i = 0, s = slot(k, x.c); i < x.c; ++i, s = (s + 1) & (x.c - 1)) {
+            if (x.t[s].first == erased_key) {
+                if (r == x.c) r = s;
+            }
+            else if (x.t[s].first == empty_key)
+                return r == x.c ? s : r;
+        }
+        return r;
+    }
+
+    //  Put an arc with a new key at slot s of x
+    static value_type* put(node& x, size_type s, K k, const V& w) {
+        ++x.n;
+        if (x.c != min_size) {
+            x.t[s] = { k, w };
+            return x.t + s;
+        }
+        x.erased &= ~(1u << s);
+        size_type i = x.n - 1;
+        for (; i > 0 && x.pos[i - 1] > s; --i) {
+            x.a[i] = x.a[i - 1];
+            x.pos[i] = x.pos[i - 1];
+        }
+        x.a[i] = { k, w };
+        x.pos[i] = std::uint8_t(s);
+        return x.a + i;
+    }
+
+    //  Move the arcs of x, in the order of their slots, into a new table of size c
+    void rehash(node& x, size_type c) {
+        if (c == x.c) return;
+        value_type tmp[inline_size];
+        value_type* src = x.c == min_size ? tmp : x.t;
+        const size_type c0 = x.c, n = x.n;
+        if (c0 == min_size)
+            std::copy(x.a, x.a + n, tmp);
+        x.c = c;
+        x.n = 0;
+        x.erased = 0;
+        if (c != min_size) x.t = allocate(c);
+        for (value_type* p = src; p != src + (c0 == min_size ? n : c0); ++p)
+            if (p->first < erased_key)
+                put(x, insert_slot(x, p->first), p->first, p->second);
+        if (c0 != min_size) release(src, c0);
+        x.resize = false;
+    }
+
+    //  Resize x as gp_hash_table does when its resize trigger is set
+    void resize_if_needed(node& x) {
+        if (!x.resize) return;
+        if (x.n >= grow_size(x.c))
+            rehash(x, 2 * x.c);
+        else if (x.c > min_size)
+            rehash(x, x.c / 2);
+    }
+
+    pair<value_type*, bool> insert_in(node& x, K k, const V& w) {
+        if (value_type* p = find_in(x, k))
+            return { p, false };
+        resize_if_needed(x);
+        value_type* p = put(x, insert_slot(x, k), k, w);
+        x.resize = x.n >= grow_size(x.c);
+        return { p, true };
+    }
+
+    //  Leave a tombstone in the slot of arc p of x
+    static void erase_at(node& x, value_type* p) {
+        --x.n;
+        if (x.c != min_size) {
+            p->first = erased_key;
+            return;
+        }
+        size_type i = p - x.a;
+        x.erased |= 1u << x.pos[i];
+        for (; i < x.n; ++i) {
+            x.a[i] = x.a[i + 1];
+            x.pos[i] = x.pos[i + 1];
+        }
+    }
+
+    bool erase_in(node& x, K k) {
+        value_type* p = find_in(x, k);
+        if (!p) return false;
+        erase_at(x, p);
+        x.resize = x.n <= shrink_size(x.c);
+        resize_if_needed(x);
+        return true;
+    }
+
+    void clear_in(node& x) {
+        if (x.c == min_size)
+            x.erased |= inline_used(x);
+        else
+            for (size_type s = 0; s < x.c; ++s)
+                if (x.t[s].first < erased_key) x.t[s].first = erased_key;
+        x.n = 0;
+        x.resize = true;
+        resize_if_needed(x);
+        x.resize = true;
+    }
+
+public:
+    //  Adjacency map of a single vertex
+    class reference {
+        adjacency_store* s;
+        node* x;
+
+        friend class adjacency_store;
+        reference(adjacency_store* s_, node* x_) : s(s_), x(x_) {}
+
+    public:
+        size_type size() const { return x->n; }
+        bool empty() const { return x->n == 0; }
+
+        iterator begin() const { return iterator(x->data(), x->data_end()); }
+        iterator end() const { return iterator(x->data_end(), x->data_end()); }
+
+        iterator find(K k) const {
+            value_type* p = s->find_in(*x, k);
+            return p ? iterator(p, x->data_end()) : end();
+        }
+
+        pair<iterator, bool> insert(const value_type& e) {
+            auto res = s->insert_in(*x, e.first, e.second);
+            return { iterator(res.first, x->data_end()), res.second };
+        }
+
+        V& operator[](K k) {
+            return s->insert_in(*x, k, V()).first->second;
+        }
+
+        size_type erase(K k) { return s->erase_in(*x, k); }
+
+        void clear() { s->clear_in(*x); }
+    };
+
+    adjacency_store() = default;
+    adjacency_store(const adjacency_store&) = delete;
+    adjacency_store& operator=(const adjacency_store&) = delete;
+
+    explicit adjacency_store(size_t n) : nodes(n) {}
+
+    size_t size() const { return nodes.size(); }
+
+    void resize(size_t n) { nodes.resize(n); }
+
+    reference operator[](size_t u) { return reference(this, &nodes[u]); }
+
+    //  Bytes held by the store
+    size_t memory_usage() const {
+        return nodes.capacity() * sizeof(node) + pool_size * sizeof(value_type);
+    }
+};
+
+}
+
+#endif
@@ -1,5 +1,7 @@
 #ifndef UTIL_HISTOGRAM_HEAP_HPP
 #define UTIL_HISTOGRAM_HEAP_HPP
+#include <cassert>
+#include <cstdint>
 #include <vector>
 #include <list>
 #include <type_traits>
@@ -19,6 +21,7 @@ using std::swap;
 using std::min;
 using std::max;
 using std::is_integral_v;
+using std::uint64_t;
 
 //  Max-heap containing n elements with key range [0, m]
 template<class K, class I = size_t>
@@ -143,6 +146,198 @@ public:
     }
 };
 
+//  Max-heap containing n elements with key range [0, m], where modify_key moves
+//  an element straight to its new key instead of one unit at a time.
+//  If the key range is within a small multiple of n, the elements are kept in
+//  per-key doubly linked lists with a hierarchical bitmap of non-empty keys,
+//  so modify_key, top and pop take O(1) time (O(log_64 m) to find the top bucket).
+//  Otherwise the elements are kept in an indexed 4-ary heap, and memory stays O(n)
+//  however large m is.
+//  Elements with equal keys are not ordered as in static_histogram_max_heap.
+template<class K, class I = size_t>
+class static_bucket_max_heap {
+public:
+    typedef K key_type;
+    typedef I size_type;
+    typedef static_bucket_max_heap<K, I> this_type;
+
+    static_assert(is_integral_v<K>, "Key type must be integral.");
+    static_assert(is_integral_v<I>, "Index type must be integral.");
+
+    //  Buckets are used if m <= bucket_factor * n + bucket_slack.
+    static constexpr size_t bucket_factor = 8;
+    static constexpr size_t bucket_slack = 1 << 12;
+
+private:
+    static constexpr size_type nil = size_type(-1);
+    static constexpr size_type arity = 4;
+
+    key_type m;
+    size_type n;                    //  Number of elements in the heap
+    bool bucketed;
+    vector<key_type> k;             //  k[i] = key of element i
+
+    //  Buckets
+    vector<size_type> head;         //  head[x] = first element with key x
+    vector<size_type> next, prev;
+    vector<vector<uint64_t>> bits;  //  bits[0] over keys, bits[l + 1] over words of bits[l]
+
+    //  4-ary heap
+    vector<size_type> h;            //  h[j] = element at heap position j
+    vector<size_type> pos;          //  pos[i] = heap position of element i
+
+    void set_bit(size_t x) {
+        for (vector<uint64_t>& b : bits) {
+            bool was_empty = b[x >> 6] == 0;
+            b[x >> 6] |= uint64_t(1) << (x & 63);
+            if (!was_empty) return;
+            x >>= 6;
+        }
+    }
+
+    void clear_bit(size_t x) {
+        for (vector<uint64_t>& b : bits) {
+            b[x >> 6] &= ~(uint64_t(1) << (x & 63));
+            if (b[x >> 6] != 0) return;
+            x >>= 6;
+        }
+    }
+
+    size_t max_bit() const {
+        size_t x = 0;
+        for (size_t l = bits.size(); l-- > 0; )
+            x = x << 6 | (63 - __builtin_clzll(bits[l][x]));
+        return x;
+    }
+
+    void link(size_type i) {
+        size_type& f = head[k[i]];
+        if (f == nil) set_bit(k[i]);
+        else prev[f] = i;
+        next[i] = f;
+        prev[i] = nil;
+        f = i;
+    }
+
+    void unlink(size_type i) {
+        if (prev[i] != nil) next[prev[i]] = next[i];
+        else if ((head[k[i]] = next[i]) == nil) clear_bit(k[i]);
+        if (next[i] != nil) prev[next[i]] = prev[i];
+    }
+
+    void place(size_type j, size_type i) {
+        h[j] = i;
+        pos[i] = j;
+    }
+
+    void sift_up(size_type j) {
+        size_type i = h[j];
+        while (j > 0) {
+            size_type q = (j - 1) / arity;
+            if (k[h[q]] >= k[i]) break;
+            place(j, h[q]);
+            j = q;
+        }
+        place(j, i);
+    }
+
+    void sift_down(size_type j) {
+        size_type i = h[j];
+        for (;;) {
+            size_type c = j * arity + 1, e = min<size_type>(c + arity, n), b = nil;
+            for (; c < e; ++c)
+                if (k[h[c]] > (b == nil ? k[i] : k[h[b]])) b = c;
+            if (b == nil) break;
+            place(j, h[b]);
+            j = b;
+        }
+        place(j, i);
+    }
+
+public:
+    static_bucket_max_heap() : m(0), n(0), bucketed(true) {}
+
+    template<class ...Args>
+    static_bucket_max_heap(key_type m_, Args&& ...args) {
+        assign(m_, forward<Args>(args)...);
+    }
+
+    template<class ...Args>
+    void assign(key_type m_, Args&& ...args) {
+        k.assign(forward<Args>(args)...);
+        m = m_;
+        n = k.size();
+        bucketed = size_t(m) <= bucket_factor * n + bucket_slack;
+        if (bucketed) {
+            head.assign(size_t(m) + 1, nil);
+            next.resize(n);
+            prev.resize(n);
+            bits.clear();
+            size_t w = size_t(m) + 1;
+            do {
+                w = (w + 63) >> 6;
+                bits.emplace_back(w, 0);
+            } while (w > 1);
+            for (size_type i = 0; i < n; ++i)
+                link(i);
+        }
+        else {
+            h.resize(n);
+            pos.resize(n);
+            for (size_type i = 0; i < n; ++i)
+                place(i, i);
+            for (size_type j = n / arity + 1; j-- > 0; )
+                if (j < n) sift_down(j);
+        }
+    }
+
+    size_type size() const { return n; }
+
+    bool empty() const { return n == 0; }
+
+    key_type key(size_type i) const { return k[i]; }
+
+    //  Element with the largest key, the heap must not be empty
+    size_type top() const {
+        assert(!empty());
+        return bucketed ? head[max_bit()] : h[0];
+    }
+
+    //  Remove the element with the largest key
+    void pop() {
+        size_type i = top();
+        --n;
+        if (bucketed)
+            unlink(i);
+        else if (n != 0) {
+            place(0, h[n]);
+            sift_down(0);
+        }
+    }
+
+    //  Modify the key value of element i to k_, i must be in the heap
+    void modify_key(size_type i, key_type k_) {
+        if (k[i] == k_) return;
+        if (bucketed) {
+            unlink(i);
+            k[i] = k_;
+            link(i);
+        }
+        else if (k_ > k[i]) {
+            k[i] = k_;
+            sift_up(pos[i]);
+        }
+        else {
+            k[i] = k_;
+            sift_down(pos[i]);
+        }
+    }
+
+    void increase_key(size_type i) { modify_key(i, k[i] + 1); }
+
+    void decrease_key(size_type i) { modify_key(i, k[i] - 1); }
+};
+
 //  Min-heap containing n elements with key range [0, m)
 template<class K, class I = size_t> 
 class static_histogram_min_heap {
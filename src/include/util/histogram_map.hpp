@@ -483,6 +483,7 @@ protected:
     size_type m;
     size_type* offsets;
     partial_value_type* values;
+    std::shared_ptr<void> storage;          //  Owner of offsets and values if they are borrowed
 
     primary_key_type locate(size_type s) const {
         return std::upper_bound(offsets, offsets + m, s) - offsets - 1;
@@ -513,6 +514,7 @@ protected:
         } 
         offsets = x.offsets;
         values = x.values;
+        storage = std::move(x.storage);
         x.m = 0;
         x.offsets = nullptr;
         x.values = nullptr;
@@ -520,10 +522,14 @@ protected:
 
     void clean() {
         if (m == 0) return;
-        for (size_type i = 0; i < size(); ++i)
-            value_alloc.destroy(values + i);
-        value_alloc.deallocate(values, size());
-        offset_alloc.deallocate(offsets, m + 1);
+        if (storage)
+            storage.reset();
+        else {
+            for (size_type i = 0; i < size(); ++i)
+                value_alloc.destroy(values + i);
+            value_alloc.deallocate(values, size());
+            offset_alloc.deallocate(offsets, m + 1);
+        }
         m = 0;
         values = nullptr;
         offsets = nullptr;
@@ -536,6 +542,41 @@ public:
     size_type size() const { return m == 0 ? 0 : offsets[m]; }
 
     bool empty() const { return size() == 0; }
+
+    //  Number of primary keys
+    size_type num_keys() const { return m; }
+
+    //  Raw arrays: num_keys() + 1 offsets followed by size() values
+    const size_type* offset_data() const { return offsets; }
+
+    const partial_value_type* value_data() const { return values; }
+
+    size_type* offset_data() { return offsets; }
+
+    partial_value_type* value_data() { return values; }
+
+    //  Allocate m_ keys and n_ values, to be filled by the caller through
+    //  offset_data() and value_data(). All n_ values must be constructed in place.
+    void allocate(size_type m_, size_type n_) {
+        clean();
+        if (m_ == 0) return;
+        m = m_;
+        offsets = offset_alloc.allocate(m + 1);
+        std::fill_n(offsets, m + 1, 0);
+        offsets[m] = n_;
+        values = value_alloc.allocate(n_);
+    }
+
+    //  Use external offsets and values arrays in place, without copying.
+    //  The arrays must stay valid and writable as long as storage is alive.
+    void adopt(size_type m_, size_type* offsets_, partial_value_type* values_, std::shared_ptr<void> storage_) {
+        clean();
+        if (m_ == 0) return;
+        m = m_;
+        offsets = offsets_;
+        values = values_;
+        storage = std::move(storage_);
+    }
     
     iterator begin() {
         return iterator{ this, 0, 0 };
@@ -597,6 +638,11 @@ public:
     using base_type::empty;
     using base_type::begin;
     using base_type::end;
+    using base_type::num_keys;
+    using base_type::offset_data;
+    using base_type::value_data;
+    using base_type::adopt;
+    using base_type::allocate;
 
     template<class FwdIt>
     void assign(size_type m_, FwdIt first, FwdIt last, elements_are_unsorted_t) {
@@ -672,11 +718,13 @@ public:
     this_type& operator=(const this_type& x) {
         clean();
         copy_from(x);
+        return *this;
     }
 
     this_type& operator=(this_type&& x) {
         clean();
         move_from(std::move(x));
+        return *this;
     }
 
     slice operator[](primary_key_type k) const {
@@ -733,6 +781,11 @@ public:
     using base_type::empty;
     using base_type::begin;
     using base_type::end;
+    using base_type::num_keys;
+    using base_type::offset_data;
+    using base_type::value_data;
+    using base_type::adopt;
+    using base_type::allocate;
 
     template<class RndIt>
     void assign(size_type m_, RndIt first, RndIt last, elements_are_unsorted_t) {
@@ -1,6 +1,11 @@
 #ifndef UTIL_HISTOGRAM_SORT_HPP
 #define UTIL_HISTOGRAM_SORT_HPP
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include <util/parallel.hpp>
 
 namespace util {
 
@@ -109,10 +114,149 @@ public:
     }
 };
 
+namespace detail {
+
+//  Key of a record for the radix sort, given by a tag of histogram_sort.
+template<class Tag>
+struct radix_key;
+
+template<template<class>class P, class K>
+struct radix_key<P<K>> {
+    static constexpr bool reversed = false;
+
+    template<class T>
+    static std::uint64_t get(const T& x) { return x.get(P<void>()); }
+};
+
+template<template<class>class P, class K>
+struct radix_key<property::reversed<P<K>>> {
+    static constexpr bool reversed = true;
+
+    template<class T>
+    static std::uint64_t get(const T& x) { return x.get(P<void>()); }
+};
+
+//  Call fn(radix_key<Tag>()) for each tag, from the last to the first.
+template<class Fn>
+void for_each_key_reversed(Fn&) {}
+
+template<class T1, class ...Ts, class Fn>
+void for_each_key_reversed(Fn& fn) {
+    for_each_key_reversed<Ts...>(fn);
+    fn(radix_key<T1>());
+}
+
+//  Records per write-combining buffer, about one cache line.
+template<class T>
+constexpr std::size_t radix_buffer_size = sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+
+//  One stable counting pass over digit(x) in [0, nb) from src to dst.
+//  Each thread counts the digits of a contiguous block, and then scatters the block
+//  through small per-digit buffers that are flushed a cache line at a time.
+//  Returns false without moving anything if all records have the same digit.
+template<class Src, class Dst, class Digit>
+bool radix_pass(Src src, Dst dst, std::size_t n, std::size_t nb, unsigned t, Digit digit) {
+    typedef typename std::iterator_traits<Src>::value_type T;
+    constexpr std::size_t L = radix_buffer_size<T>;
+    std::vector<std::vector<std::size_t>> pos(t);
+    util::parallel_blocks(t, n, [&](unsigned i, std::size_t l, std::size_t r) {
+        pos[i].assign(nb, 0);
+        std::size_t* c = pos[i].data();
+        for (std::size_t j = l; j < r; ++j)
+            c[digit(src[j])]++;
+    });
+    std::size_t s = 0;
+    for (std::size_t d = 0; d < nb; ++d) {
+        std::size_t s0 = s;
+        for (unsigned i = 0; i < pos.size(); ++i) {
+            std::size_t c = pos[i][d];
+            pos[i][d] = s;
+            s += c;
+        }
+        if (s - s0 == n) return false;
+    }
+    util::parallel_blocks(t, n, [&](unsigned i, std::size_t l, std::size_t r) {
+        std::size_t* p = pos[i].data();
+        std::unique_ptr<T[]> buf(new T[nb * L]);
+        std::vector<unsigned char> fill(nb, 0);
+        for (std::size_t j = l; j < r; ++j) {
+            std::size_t d = digit(src[j]);
+            T* b = buf.get() + d * L;
+            b[fill[d]++] = src[j];
+            if (fill[d] == L) {
+                std::copy(b, b + L, dst + p[d]);
+                p[d] += L;
+                fill[d] = 0;
+            }
+        }
+        for (std::size_t d = 0; d < nb; ++d) {
+            T* b = buf.get() + d * L;
+            std::copy(b, b + fill[d], dst + p[d]);
+        }
+    });
+    return true;
+}
+
+//  Parallel LSD radix sort, the last tag is sorted first.
+//  Each key takes as many passes of at most 11 bits as its range needs.
+template<class RndIt, class ...Ts>
+void radix_sort(RndIt begin, RndIt end, unsigned t) {
+    typedef typename std::iterator_traits<RndIt>::value_type T;
+    const std::size_t n = end - begin;
+    std::unique_ptr<T[]> tmp(new T[n]);
+    bool in_tmp = false;
+
+    auto sort_by = [&](auto key) {
+        typedef decltype(key) key_type;
+        std::vector<std::uint64_t> mx(t, 0);
+        util::parallel_blocks(t, n, [&](unsigned i, std::size_t l, std::size_t r) {
+            std::uint64_t x = 0;
+            for (std::size_t j = l; j < r; ++j)
+                x = std::max(x, key_type::get(begin[j]));
+            mx[i] = x;
+        });
+        const std::uint64_t k_max = *std::max_element(mx.begin(), mx.end());
+        int bits = 0;
+        while (bits < 64 && (k_max >> bits) != 0) ++bits;
+        if (bits == 0) return;
+        const int passes = (bits + 10) / 11;
+        const int width = (bits + passes - 1) / passes;
+        const std::uint64_t mask = (std::uint64_t(1) << width) - 1;
+        for (int q = 0; q < passes; ++q) {
+            const int shift = q * width;
+            auto digit = [=](const T& x) {
+                std::uint64_t k = key_type::get(x);
+                if (key_type::reversed) k = k_max - k;
+                return std::size_t((k >> shift) & mask);
+            };
+            if (in_tmp ? radix_pass(tmp.get(), begin, n, mask + 1, t, digit)
+                       : radix_pass(begin, tmp.get(), n, mask + 1, t, digit))
+                in_tmp = !in_tmp;
+        }
+    };
+    for_each_key_reversed<Ts...>(sort_by);
+    if (in_tmp)
+        util::parallel_blocks(t, n, [&](unsigned, std::size_t l, std::size_t r) {
+            std::copy(tmp.get() + l, tmp.get() + r, begin + l);
+        });
+}
+
+}
+
+//  Inputs with fewer records are sorted by histogram_sorter on one thread.
+constexpr std::size_t radix_sort_threshold = 1 << 16;
+
+//  Stable sort of [begin, end) by the keys given by tags, the first tag is the most significant.
+//  A tag property::reversed<P<>> sorts by key P in descending order.
+//  Keys must be non-negative integers.
 template<class RndIt, class ...Ts>
 void histogram_sort(RndIt begin, RndIt end, Ts...) {
     if (begin == end) return ;
-    histogram_sorter<RndIt, size_t, Ts...>(distance(begin, end), 0, begin);
+    std::size_t n = distance(begin, end);
+    if (n < radix_sort_threshold)
+        histogram_sorter<RndIt, size_t, Ts...>(n, 0, begin);
+    else
+        detail::radix_sort<RndIt, Ts...>(begin, end, util::num_threads());
 }
 
 }
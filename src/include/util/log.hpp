@@ -8,9 +8,10 @@
 namespace util {
 
 using std::string;
+using std::to_string;
 using std::unordered_map;
 
-unordered_map<string, string> log_map;
+inline unordered_map<string, string> log_map;
 
 template<class T>
 void log(string key, T value) {
@@ -21,8 +22,8 @@ template<class T>
 void log(string key, const std::vector<T>& value) {
     std::stringstream ss;
     for (size_t i = 0; i < value.size(); ++i) {
-        ss << to_string(v);
-        if (i + 1 == value.size())
+        ss << to_string(value[i]);
+        if (i + 1 < value.size())
             ss << ' ';
     }
     log_map[key] = ss.str();
@@ -0,0 +1,128 @@
+#ifndef UTIL_MAPPED_FILE_HPP
+#define UTIL_MAPPED_FILE_HPP
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define UTIL_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define UTIL_HAVE_MMAP 0
+#endif
+
+namespace util {
+
+//  View of a whole file.
+//  The file is mapped with mmap where available, otherwise it is read into memory.
+//  A file opened as writable is mapped copy-on-write: writes through mutable_data() stay
+//  private to the process and never reach the file.
+class mapped_file {
+    typedef mapped_file this_type;
+
+    char* p;
+    std::size_t n;
+    bool mapped;
+    std::vector<char> buf;
+
+public:
+    mapped_file() : p(nullptr), n(0), mapped(false) {}
+
+    explicit mapped_file(const std::string& path, bool writable = false) : mapped_file() {
+        open(path, writable);
+    }
+
+    mapped_file(const this_type&) = delete;
+    this_type& operator=(const this_type&) = delete;
+
+    mapped_file(this_type&& x) noexcept
+        : p(std::exchange(x.p, nullptr)), n(std::exchange(x.n, 0)),
+          mapped(std::exchange(x.mapped, false)), buf(std::move(x.buf)) {
+        if (!mapped && !buf.empty()) p = buf.data();
+    }
+
+    this_type& operator=(this_type&& x) noexcept {
+        close();
+        p = std::exchange(x.p, nullptr);
+        n = std::exchange(x.n, 0);
+        mapped = std::exchange(x.mapped, false);
+        buf = std::move(x.buf);
+        if (!mapped && !buf.empty()) p = buf.data();
+        return *this;
+    }
+
+    ~mapped_file() { close(); }
+
+    bool open(const std::string& path, bool writable = false) {
+        close();
+#if UTIL_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        n = st.st_size;
+        if (n != 0) {
+            void* q = mmap(nullptr, n, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+            if (q == MAP_FAILED) {
+                ::close(fd);
+                n = 0;
+                return false;
+            }
+            madvise(q, n, MADV_WILLNEED);
+            p = static_cast<char*>(q);
+            mapped = true;
+        }
+        ::close(fd);
+        return true;
+#else
+        (void)writable;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (f == nullptr) return false;
+        char tmp[1 << 16];
+        std::size_t r;
+        while ((r = fread(tmp, 1, sizeof(tmp), f)) != 0)
+            buf.insert(buf.end(), tmp, tmp + r);
+        fclose(f);
+        n = buf.size();
+        p = buf.data();
+        return true;
+#endif
+    }
+
+    void close() {
+#if UTIL_HAVE_MMAP
+        if (mapped)
+            munmap(p, n);
+#endif
+        p = nullptr;
+        n = 0;
+        mapped = false;
+        buf.clear();
+        buf.shrink_to_fit();
+    }
+
+    const char* data() const { return p; }
+
+    //  Only for a file opened as writable
+    char* mutable_data() { return p; }
+
+    const char* begin() const { return p; }
+
+    const char* end() const { return p + n; }
+
+    std::size_t size() const { return n; }
+
+    bool is_mapped() const { return mapped; }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef UTIL_PARALLEL_HPP
+#define UTIL_PARALLEL_HPP
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <util/profile.hpp>
+
+namespace util {
+
+//  Number of threads used by the parallel code paths, hardware concurrency by default.
+inline unsigned& num_threads_ref() {
+    static unsigned t = std::max(1u, std::thread::hardware_concurrency());
+    return t;
+}
+
+inline unsigned num_threads() { return num_threads_ref(); }
+
+inline void set_num_threads(unsigned t) { num_threads_ref() = std::max(1u, t); }
+
+namespace detail {
+//  Whether the calling thread runs a task of a work_stealing_pool, kept by the pool
+inline thread_local bool in_pool_task = false;
+}
+
+//  Call fn(i) for each i in [0, t), each on its own thread.
+//  The calling thread runs fn(0). Within a task of a work_stealing_pool, whose other workers
+//  run the other tasks, the calling thread runs them all in order instead.
+template<class Fn>
+void parallel_invoke(unsigned t, Fn&& fn) {
+    if (t <= 1 || detail::in_pool_task) {
+        for (unsigned i = 0; i < std::max(t, 1u); ++i)
+            fn(i);
+        return;
+    }
+    std::vector<std::thread> ts;
+    ts.reserve(t - 1);
+    profile::node* phase = profile::current();
+    for (unsigned i = 1; i < t; ++i)
+        ts.emplace_back([&fn, i, phase]() {
+            profile::adopt a(phase);
+            fn(i);
+        });
+    fn(0u);
+    for (std::thread& th : ts)
+        th.join();
+}
+
+//  Split [0, n) into t contiguous blocks and call fn(i, l, r) for the i-th block [l, r).
+template<class S, class Fn>
+void parallel_blocks(unsigned t, S n, Fn&& fn) {
+    if (n < (S)t) t = n;
+    if (t == 0) t = 1;
+    parallel_invoke(t, [&](unsigned i) {
+        S l = n / t * i + std::min<S>(i, n % t);
+        S r = l + n / t + (i < n % t);
+        fn(i, l, r);
+    });
+}
+
+}
+
+#endif
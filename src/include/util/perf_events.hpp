@@ -0,0 +1,121 @@
+#ifndef UTIL_PERF_EVENTS_HPP
+#define UTIL_PERF_EVENTS_HPP
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+struct perf_event_spec {
+    const char* name;
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+//  Cycles, instructions, last level cache misses, branch misses and data TLB misses
+inline const std::vector<perf_event_spec>& default_perf_events() {
+#ifdef __linux__
+    static const std::vector<perf_event_spec> events = {
+        { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { "llc_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { "dtlb_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    };
+#else
+    static const std::vector<perf_event_spec> events;
+#endif
+    return events;
+}
+
+//  Counters of the calling thread in user space, opened as one group by perf_event_open(2) so
+//  that they are scheduled together and read by a single system call. Events the kernel or the
+//  processor does not support are left out. If the counters are multiplexed, the values are
+//  scaled by the share of the time they were counting. Not available outside Linux.
+class perf_group {
+    int leader = -1;
+    std::vector<int> fds;
+    std::vector<const char*> names;
+    int err = 0;
+    mutable std::vector<std::uint64_t> buf;
+
+#ifdef __linux__
+    static int open_event(const perf_event_spec& e, int group) {
+        perf_event_attr a;
+        std::memset(&a, 0, sizeof(a));
+        a.size = sizeof(a);
+        a.type = e.type;
+        a.config = e.config;
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        a.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(SYS_perf_event_open, &a, 0, -1, group, 0));
+    }
+#endif
+
+public:
+    explicit perf_group(const std::vector<perf_event_spec>& events = default_perf_events()) {
+#ifdef __linux__
+        for (const perf_event_spec& e : events) {
+            int fd = open_event(e, leader);
+            if (fd < 0) {
+                if (err == 0) err = errno;
+                continue;
+            }
+            if (leader < 0) leader = fd;
+            fds.push_back(fd);
+            names.push_back(e.name);
+        }
+        if (leader >= 0) err = 0;
+        buf.resize(3 + fds.size());
+#else
+        (void)events;
+        err = ENOSYS;
+#endif
+    }
+
+    perf_group(const perf_group&) = delete;
+    perf_group& operator=(const perf_group&) = delete;
+
+    ~perf_group() {
+#ifdef __linux__
+        for (int fd : fds)
+            close(fd);
+#endif
+    }
+
+    bool ok() const { return leader >= 0; }
+
+    //  errno of the first event that could not be opened if none could, 0 otherwise
+    int error() const { return err; }
+
+    //  Names of the events counted, in the order of the values of read
+    const std::vector<const char*>& events() const { return names; }
+
+    //  Values of the counters since the group was opened. Returns false if they can not be read.
+    bool read(std::uint64_t* v) const {
+#ifdef __linux__
+        if (leader < 0) return false;
+        const std::size_t size = buf.size() * sizeof(std::uint64_t);
+        if (::read(leader, buf.data(), size) != ssize_t(size) || buf[0] != fds.size())
+            return false;
+        const std::uint64_t enabled = buf[1], running = buf[2];
+        for (std::size_t i = 0; i < fds.size(); ++i)
+            v[i] = running == 0 ? 0 : running == enabled ? buf[3 + i] : std::uint64_t(double(buf[3 + i]) * enabled / running);
+        return true;
+#else
+        (void)v;
+        return false;
+#endif
+    }
+};
+
+}
+
+#endif
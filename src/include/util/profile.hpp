@@ -0,0 +1,380 @@
+#ifndef UTIL_PROFILE_HPP
+#define UTIL_PROFILE_HPP
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include <util/perf_events.hpp>
+
+namespace util {
+
+//  Hierarchical phase timers and counters, off until enable() is called.
+//  A scope object times a phase, named by a string literal, from its construction to its
+//  destruction. Phases entered while another one is open on the same thread are its children,
+//  and so are the phases of tasks spawned into a work_stealing_pool or run by parallel_invoke
+//  from within it. Each phase keeps its number of calls, its total time on steady_clock, the
+//  peak resident memory of the process when it was left, and counters added by count().
+//  Times of phases run by several threads at once add up, and may exceed that of the parent.
+//  The tree of phases is shared by all threads, and finding a child is lock-free. Calls, times
+//  and counters are added up by each thread on its own, and into the tree when it exits or at
+//  the report, so that threads in the same phase do not write to the same memory.
+//  A disabled scope costs a relaxed load. report_json and report_csv must be called once the
+//  phases are closed and the tasks that ran them are synchronized.
+//  With enable_hw, the phases also count hardware events, such as cycles and cache misses, on
+//  each thread that runs them. The work of tasks is counted in the phase they were spawned from.
+namespace profile {
+
+struct counter {
+    const char* name;
+    std::int64_t value = 0;
+    counter* next = nullptr;
+};
+
+//  calls, ns and counters are written by detail::local::flush only
+struct node {
+    const char* name;
+    node* parent;
+    std::uint64_t calls = 0, ns = 0;
+    std::atomic<long> max_rss_kb{ 0 };
+    std::atomic<node*> children{ nullptr };
+    node* next = nullptr;
+    counter* counters = nullptr;
+
+    node(const char* name_, node* parent_) : name(name_), parent(parent_) {}
+
+    ~node() {
+        for (node* c = children.load(); c;) {
+            node* x = c->next;
+            delete c;
+            c = x;
+        }
+        for (counter* c = counters; c;) {
+            counter* x = c->next;
+            delete c;
+            c = x;
+        }
+    }
+
+    //  Find or insert an element of a list by name
+    template<class T, class... Args>
+    static T* find(std::atomic<T*>& head, const char* name, Args... args) {
+        T* h = head.load(std::memory_order_acquire);
+        for (T* x = h; x; x = x->next)
+            if (std::strcmp(x->name, name) == 0) return x;
+        T* y = new T(args...);
+        y->name = name;
+        for (;;) {
+            y->next = h;
+            if (head.compare_exchange_weak(h, y, std::memory_order_acq_rel, std::memory_order_acquire))
+                return y;
+            //  Another thread may have inserted it meanwhile
+            for (T* x = h; x && x != y->next; x = x->next)
+                if (std::strcmp(x->name, name) == 0) {
+                    delete y;
+                    return x;
+                }
+        }
+    }
+
+    node* child(const char* name_) { return find(children, name_, name_, this); }
+
+    void add(const char* name_, std::int64_t k) {
+        counter* c = counters;
+        while (c && std::strcmp(c->name, name_) != 0) c = c->next;
+        if (!c) {
+            c = new counter{ name_ };
+            c->next = counters;
+            counters = c;
+        }
+        c->value += k;
+    }
+};
+
+inline std::atomic<bool> enabled{ false }, started{ false };
+inline node root("total", nullptr);
+inline thread_local node* cur = nullptr;
+inline std::chrono::steady_clock::time_point t_enabled;
+
+//  The root phase lasts from the first call to enable() until the report
+inline void enable(bool on = true) {
+    if (on && !started.exchange(true)) {
+        t_enabled = std::chrono::steady_clock::now();
+        root.calls = 1;
+    }
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+inline bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+//  Innermost phase of this thread, nullptr outside of any phase
+inline node* current() { return cur; }
+
+inline long peak_rss_kb() {
+    rusage ru;
+    return getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss : 0;
+}
+
+constexpr std::size_t max_hw_events = 8;
+inline std::atomic<bool> hw_enabled{ false };
+inline std::vector<perf_event_spec> hw_events;
+
+namespace detail {
+
+class local;
+inline std::mutex locals_mutex;
+inline std::vector<local*> locals;
+
+//  Calls, times and counters of the phases run by one thread, not yet added to the tree
+class local {
+    struct stats {
+        std::uint64_t calls = 0, ns = 0;
+        std::vector<std::pair<const char*, std::int64_t>> counters;
+    };
+    std::unordered_map<node*, stats> s;
+
+public:
+    local() {
+        std::lock_guard<std::mutex> lock(locals_mutex);
+        locals.push_back(this);
+    }
+
+    local(const local&) = delete;
+    local& operator=(const local&) = delete;
+
+    ~local() {
+        std::lock_guard<std::mutex> lock(locals_mutex);
+        flush();
+        locals.erase(std::find(locals.begin(), locals.end(), this));
+    }
+
+    void time(node* n, std::uint64_t ns) {
+        stats& x = s[n];
+        ++x.calls;
+        x.ns += ns;
+    }
+
+    void add(node* n, const char* name, std::int64_t k) {
+        for (std::pair<const char*, std::int64_t>& c : s[n].counters)
+            if (c.first == name || std::strcmp(c.first, name) == 0) {
+                c.second += k;
+                return;
+            }
+        s[n].counters.emplace_back(name, k);
+    }
+
+    //  Add to the tree and clear, with locals_mutex held
+    void flush() {
+        for (std::pair<node* const, stats>& x : s) {
+            x.first->calls += x.second.calls;
+            x.first->ns += x.second.ns;
+            for (const std::pair<const char*, std::int64_t>& c : x.second.counters)
+                x.first->add(c.first, c.second);
+        }
+        s.clear();
+    }
+};
+
+inline local& this_thread() {
+    thread_local local l;
+    return l;
+}
+
+//  Counters of this thread, opened on first use
+inline perf_group& hw_group() {
+    thread_local std::unique_ptr<perf_group> g(new perf_group(hw_events));
+    return *g;
+}
+
+//  Adds the events counted by this thread between start and stop to a phase
+class hw_sample {
+    perf_group* g = nullptr;
+    std::uint64_t v0[max_hw_events];
+
+public:
+    void start() {
+        if (!hw_enabled.load(std::memory_order_relaxed)) return;
+        g = &hw_group();
+        if (!g->read(v0)) g = nullptr;
+    }
+
+    void stop(node* n) {
+        std::uint64_t v1[max_hw_events];
+        if (!g || !g->read(v1)) return;
+        const std::vector<const char*>& ev = g->events();
+        for (std::size_t i = 0; i < ev.size(); ++i)
+            this_thread().add(n, ev[i], std::int64_t(v1[i] - v0[i]));
+    }
+};
+
+}
+
+//  Count the given events in the phases, with profiling enabled. Returns false with errno set
+//  if none of them can be counted on the calling thread, as when the kernel does not allow it,
+//  in which case only times are kept.
+inline bool enable_hw(const std::vector<perf_event_spec>& events = default_perf_events()) {
+    hw_events.assign(events.begin(), events.begin() + std::min(events.size(), max_hw_events));
+    const perf_group& g = detail::hw_group();
+    hw_enabled.store(g.ok(), std::memory_order_relaxed);
+    if (!g.ok()) errno = g.error();
+    return g.ok();
+}
+
+class scope {
+    node* n = nullptr;
+    node* prev;
+    std::chrono::steady_clock::time_point t0;
+    detail::hw_sample hw;
+
+public:
+    explicit scope(const char* name) {
+        if (!is_enabled()) return;
+        prev = cur;
+        n = (prev ? prev : &root)->child(name);
+        cur = n;
+        hw.start();
+        t0 = std::chrono::steady_clock::now();
+    }
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    ~scope() {
+        if (!n) return;
+        detail::this_thread().time(n, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+        hw.stop(n);
+        long rss = peak_rss_kb(), m = n->max_rss_kb.load(std::memory_order_relaxed);
+        while (rss > m && !n->max_rss_kb.compare_exchange_weak(m, rss, std::memory_order_relaxed));
+        cur = prev;
+    }
+};
+
+//  Makes the phases of this thread children of p, for tasks run on behalf of another thread.
+//  Events are counted in p unless this thread is already in a phase, which counts them.
+class adopt {
+    node* p;
+    node* prev;
+    detail::hw_sample hw;
+
+public:
+    explicit adopt(node* p_) : p(p_), prev(cur) {
+        cur = p;
+        if (p && !prev) hw.start();
+    }
+    adopt(const adopt&) = delete;
+    adopt& operator=(const adopt&) = delete;
+    ~adopt() {
+        if (p && !prev) hw.stop(p);
+        cur = prev;
+    }
+};
+
+//  Add k to the counter name of the innermost phase of this thread
+inline void count(const char* name, std::int64_t k) {
+    if (!is_enabled()) return;
+    detail::this_thread().add(cur ? cur : &root, name, k);
+}
+
+namespace detail {
+
+//  Add up the phases of all threads and close the root
+inline void close_root() {
+    std::lock_guard<std::mutex> lock(locals_mutex);
+    for (local* l : locals)
+        l->flush();
+    root.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t_enabled).count();
+    root.max_rss_kb = peak_rss_kb();
+}
+
+//  Elements of a list in the order they were inserted
+template<class T>
+std::vector<const T*> in_order(const T* head) {
+    std::vector<const T*> r;
+    for (const T* x = head; x; x = x->next)
+        r.push_back(x);
+    return std::vector<const T*>(r.rbegin(), r.rend());
+}
+
+inline std::string escape(const char* s) {
+    std::string r;
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') r += '\\';
+        r += *s;
+    }
+    return r;
+}
+
+inline void write_json(std::ostream& os, const node& x, int depth) {
+    const std::string pad(2 * depth, ' ');
+    os << pad << "{\"name\": \"" << escape(x.name) << "\", \"calls\": " << x.calls
+       << ", \"seconds\": " << x.ns / 1e9 << ", \"max_rss_kb\": " << x.max_rss_kb.load()
+       << ", \"counters\": {";
+    bool first = true;
+    for (const counter* c : in_order(x.counters)) {
+        os << (first ? "" : ", ") << '"' << escape(c->name) << "\": " << c->value;
+        first = false;
+    }
+    os << "}, \"children\": [";
+    first = true;
+    for (const node* c : in_order(x.children.load())) {
+        os << (first ? "\n" : ",\n");
+        write_json(os, *c, depth + 1);
+        first = false;
+    }
+    os << (first ? "" : "\n" + pad) << "]}";
+}
+
+inline void write_csv(std::ostream& os, const node& x, const std::string& path) {
+    os << path << ",calls," << x.calls << '\n';
+    os << path << ",seconds," << x.ns / 1e9 << '\n';
+    os << path << ",max_rss_kb," << x.max_rss_kb.load() << '\n';
+    for (const counter* c : in_order(x.counters))
+        os << path << ',' << c->name << ',' << c->value << '\n';
+    for (const node* c : in_order(x.children.load()))
+        write_csv(os, *c, path + "/" + c->name);
+}
+
+}
+
+//  The tree of phases as nested objects with name, calls, seconds, max_rss_kb, counters
+//  and children. The root holds the counters added outside of any phase.
+inline void report_json(std::ostream& os) {
+    detail::close_root();
+    detail::write_json(os, root, 0);
+    os << '\n';
+}
+
+//  One row Phase,Metric,Value per metric, where Phase is the path of names from the root
+inline void report_csv(std::ostream& os) {
+    detail::close_root();
+    os << "Phase,Metric,Value\n";
+    detail::write_csv(os, root, root.name);
+}
+
+//  Write the report to path, as JSON if its name ends in .json and as CSV otherwise.
+//  Returns false if it can not be written.
+inline bool report(const std::string& path) {
+    std::ofstream ofs(path);
+    if (!ofs) return false;
+    if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0)
+        report_json(ofs);
+    else
+        report_csv(ofs);
+    return bool(ofs);
+}
+
+}
+
+}
+
+#endif
@@ -88,7 +88,7 @@ public:
     }
 
     template<class U, class R>
-    this_type& assign(U&& u, R r) {
+    this_type& assign(U&&, R) {
         return *this;
     }
 
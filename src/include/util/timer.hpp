@@ -4,7 +4,7 @@
 #include <iostream>
 
 namespace util {
-    auto now() { return std::chrono::system_clock::now(); }
+    inline auto now() { return std::chrono::steady_clock::now(); }
 
     struct timer {
         decltype(now()) a;
@@ -0,0 +1,381 @@
+#ifndef UTIL_WORK_STEALING_HPP
+#define UTIL_WORK_STEALING_HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <util/parallel.hpp>
+#include <util/profile.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace util {
+
+class work_stealing_pool;
+class task_group;
+
+namespace detail {
+
+struct task_base {
+    task_group* g;
+    profile::node* phase;       //  Phase of the spawning thread
+    explicit task_base(task_group* g_) : g(g_), phase(profile::current()) {}
+    virtual ~task_base() = default;
+    virtual void run() = 0;
+};
+
+template<class Fn>
+struct task_impl : task_base {
+    Fn fn;
+    task_impl(task_group* g_, Fn&& fn_) : task_base(g_), fn(std::forward<Fn>(fn_)) {}
+    void run() override {
+        profile::adopt a(phase);
+        fn();
+    }
+};
+
+//  Chase-Lev deque of tasks. The owner pushes and takes at the bottom, thieves steal at the top.
+//  D. Chase, Y. Lev. (2005). Dynamic circular work-stealing deque. SPAA '05.
+//  N. M. Le, A. Pop, A. Cohen, F. Zappa Nardelli. (2013).
+//  Correct and efficient work-stealing for weak memory models. PPoPP '13.
+class task_deque {
+    struct ring {
+        std::int64_t cap;
+        std::unique_ptr<std::atomic<task_base*>[]> a;
+
+        explicit ring(std::int64_t cap_) : cap(cap_), a(new std::atomic<task_base*>[cap_]) {}
+        task_base* get(std::int64_t i) const { return a[i & (cap - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, task_base* t) { a[i & (cap - 1)].store(t, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<std::int64_t> top;
+    alignas(64) std::atomic<std::int64_t> bottom;
+    std::atomic<ring*> r;
+    std::vector<std::unique_ptr<ring>> rings;   //  Outgrown rings are kept, thieves may still read them
+
+public:
+    task_deque() : top(0), bottom(0) {
+        rings.emplace_back(new ring(64));
+        r.store(rings.back().get());
+    }
+
+    bool empty() const { return bottom.load() <= top.load(); }
+
+    void push(task_base* t) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed), tp = top.load(std::memory_order_acquire);
+        ring* a = r.load(std::memory_order_relaxed);
+        if (b - tp > a->cap - 1) {
+            rings.emplace_back(new ring(2 * a->cap));
+            ring* a2 = rings.back().get();
+            for (std::int64_t i = tp; i < b; ++i)
+                a2->put(i, a->get(i));
+            r.store(a2, std::memory_order_release);
+            a = a2;
+        }
+        a->put(b, t);
+        bottom.store(b + 1, std::memory_order_seq_cst);
+    }
+
+    task_base* take() {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        ring* a = r.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_seq_cst);
+        std::int64_t tp = top.load(std::memory_order_seq_cst);
+        if (tp > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        task_base* t = a->get(b);
+        if (tp == b) {
+            //  Last task, race against thieves
+            if (!top.compare_exchange_strong(tp, tp + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                t = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    task_base* steal() {
+        std::int64_t tp = top.load(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_seq_cst);
+        if (tp >= b) return nullptr;
+        ring* a = r.load(std::memory_order_acquire);
+        task_base* t = a->get(tp);
+        if (!top.compare_exchange_strong(tp, tp + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return t;
+    }
+};
+
+}
+
+//  Counters of a worker of work_stealing_pool
+struct worker_stats {
+    std::uint64_t tasks = 0;        //  Tasks run
+    std::uint64_t steals = 0;       //  Tasks stolen from other workers
+    std::uint64_t parks = 0;        //  Times the worker went to sleep
+    double idle_seconds = 0;        //  Time spent looking for work or asleep
+};
+
+//  Fork/join pool of workers, each with its own Chase-Lev deque.
+//  Worker 0 is the thread that constructs the pool, the other workers are threads of the pool.
+//  Tasks are spawned into a task_group and run by any worker. A worker whose deque is empty
+//  steals from a random other worker; after spin_rounds failed attempts it sleeps until new
+//  tasks are spawned. Waiting in task_group::sync runs other tasks meanwhile.
+//  Only worker threads may spawn tasks or wait on a task group.
+class work_stealing_pool {
+public:
+    static constexpr unsigned spin_rounds = 1024;
+
+private:
+    friend class task_group;
+
+    struct alignas(64) worker {
+        detail::task_deque q;
+        std::atomic<std::uint64_t> tasks{ 0 }, steals{ 0 }, parks{ 0 }, idle_ns{ 0 };
+        std::uint64_t seed;
+    };
+
+    std::vector<std::unique_ptr<worker>> ws;
+    std::vector<std::thread> ts;
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::atomic<unsigned> sleepers;
+    std::uint64_t epoch;            //  Number of wake-ups, guarded by m
+    bool stop;
+
+    static inline thread_local work_stealing_pool* cur_pool = nullptr;
+    static inline thread_local unsigned cur_worker = 0;
+    work_stealing_pool* prev_pool;
+    unsigned prev_worker;
+
+    static void pin(unsigned i) {
+#ifdef __linux__
+        unsigned c = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t s;
+        CPU_ZERO(&s);
+        CPU_SET(i % c, &s);
+        pthread_setaffinity_np(pthread_self(), sizeof(s), &s);
+#else
+        (void)i;
+#endif
+    }
+
+    bool has_work() const {
+        for (const auto& w : ws)
+            if (!w->q.empty()) return true;
+        return false;
+    }
+
+    //  Take a task of worker i, or steal one from another worker
+    detail::task_base* find(unsigned i) {
+        worker& w = *ws[i];
+        if (detail::task_base* t = w.q.take())
+            return t;
+        const unsigned k = ws.size();
+        if (k == 1) return nullptr;
+        w.seed = w.seed * 6364136223846793005ull + 1442695040888963407ull;
+        unsigned d = (w.seed >> 33) % (k - 1) + 1;
+        for (unsigned j = 0; j + 1 < k; ++j) {
+            if (detail::task_base* t = ws[(i + d + j) % k]->q.steal()) {
+                w.steals.fetch_add(1, std::memory_order_relaxed);
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    inline void execute(unsigned i, detail::task_base* t);
+
+    void notify() {
+        if (sleepers.load() == 0) return;
+        std::lock_guard<std::mutex> l(m);
+        ++epoch;
+        cv.notify_all();
+    }
+
+    void work(unsigned i) {
+        cur_pool = this;
+        cur_worker = i;
+        worker& w = *ws[i];
+        for (;;) {
+            auto t0 = std::chrono::steady_clock::now();
+            detail::task_base* t = nullptr;
+            for (unsigned r = 0; !t && r < spin_rounds; ++r) {
+                if ((t = find(i))) break;
+                if (r >= spin_rounds / 2) std::this_thread::yield();
+            }
+            if (!t) {
+                std::unique_lock<std::mutex> l(m);
+                if (stop) return;
+                std::uint64_t e = epoch;
+                sleepers.fetch_add(1);
+                if (!has_work()) {
+                    w.parks.fetch_add(1, std::memory_order_relaxed);
+                    cv.wait(l, [&]() { return stop || epoch != e; });
+                }
+                sleepers.fetch_sub(1);
+                if (stop) return;
+            }
+            w.idle_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count(), std::memory_order_relaxed);
+            if (t) execute(i, t);
+        }
+    }
+
+public:
+    //  With pin_threads, worker i runs on CPU i modulo the number of CPUs
+    explicit work_stealing_pool(unsigned t = num_threads(), bool pin_threads = false)
+        : sleepers(0), epoch(0), stop(false), prev_pool(cur_pool), prev_worker(cur_worker) {
+        t = std::max(t, 1u);
+        for (unsigned i = 0; i < t; ++i) {
+            ws.emplace_back(new worker());
+            ws.back()->seed = i + 1;
+        }
+        cur_pool = this;
+        cur_worker = 0;
+        if (pin_threads) pin(0);
+        for (unsigned i = 1; i < t; ++i)
+            ts.emplace_back([this, i, pin_threads]() {
+                if (pin_threads) pin(i);
+                work(i);
+            });
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    ~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> l(m);
+            stop = true;
+            cv.notify_all();
+        }
+        for (std::thread& th : ts)
+            th.join();
+        cur_pool = prev_pool;
+        cur_worker = prev_worker;
+    }
+
+    unsigned num_workers() const { return ws.size(); }
+
+    //  Index of the calling worker in [0, num_workers())
+    static unsigned worker_index() { return cur_worker; }
+
+    //  Pool of the calling worker, nullptr if the calling thread is not a worker
+    static work_stealing_pool* current() { return cur_pool; }
+
+    std::vector<worker_stats> stats() const {
+        std::vector<worker_stats> res(ws.size());
+        for (std::size_t i = 0; i < ws.size(); ++i) {
+            res[i].tasks = ws[i]->tasks.load();
+            res[i].steals = ws[i]->steals.load();
+            res[i].parks = ws[i]->parks.load();
+            res[i].idle_seconds = ws[i]->idle_ns.load() * 1e-9;
+        }
+        return res;
+    }
+
+    //  Call fn(l, r) on blocks [l, r) of [begin, end) with at most grain elements,
+    //  obtained by recursive halving, and wait for all of them
+    template<class S, class Fn>
+    void parallel_for(S begin, S end, S grain, Fn&& fn);
+};
+
+//  Group of tasks that can be waited for together.
+//  Tasks of a group may spawn further tasks into the same group.
+class task_group {
+    friend class work_stealing_pool;
+
+    work_stealing_pool& pool;
+    std::atomic<std::size_t> pending;
+
+public:
+    explicit task_group(work_stealing_pool& pool_) : pool(pool_), pending(0) {}
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+    ~task_group() { sync(); }
+
+    work_stealing_pool& get_pool() const { return pool; }
+
+    template<class Fn>
+    void spawn(Fn&& fn) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        auto* t = new detail::task_impl<std::decay_t<Fn>>(this, std::decay_t<Fn>(std::forward<Fn>(fn)));
+        pool.ws[work_stealing_pool::cur_worker]->q.push(t);
+        pool.notify();
+    }
+
+    //  Run tasks until all tasks of the group are finished
+    void sync() {
+        const unsigned i = work_stealing_pool::cur_worker;
+        while (pending.load(std::memory_order_acquire) != 0) {
+            if (detail::task_base* t = pool.find(i))
+                pool.execute(i, t);
+            else
+                std::this_thread::yield();
+        }
+    }
+};
+
+inline void work_stealing_pool::execute(unsigned i, detail::task_base* t) {
+    task_group* g = t->g;
+    const bool in_task = detail::in_pool_task;
+    detail::in_pool_task = true;
+    t->run();
+    detail::in_pool_task = in_task;
+    delete t;
+    ws[i]->tasks.fetch_add(1, std::memory_order_relaxed);
+    g->pending.fetch_sub(1, std::memory_order_release);
+}
+
+template<class S, class Fn>
+void work_stealing_pool::parallel_for(S begin, S end, S grain, Fn&& fn) {
+    grain = std::max<S>(grain, 1);
+    task_group g(*this);
+    auto rec = [&](auto& self, S l, S r) -> void {
+        while (r - l > grain) {
+            S mid = l + (r - l) / 2;
+            g.spawn([&self, mid, r]() { self(self, mid, r); });
+            r = mid;
+        }
+        fn(l, r);
+    };
+    if (begin < end)
+        rec(rec, begin, end);
+    g.sync();
+}
+
+//  Pool of the calling worker, or a pool with num_threads() workers owned by this object if
+//  the calling thread is not a worker. A solver called by a task of another solver thereby
+//  runs on the workers of the outer one instead of starting a pool of its own.
+class pool_ref {
+    std::unique_ptr<work_stealing_pool> own;
+    work_stealing_pool* pool;
+
+public:
+    pool_ref() : pool(work_stealing_pool::current()) {
+        if (!pool) {
+            own.reset(new work_stealing_pool());
+            pool = own.get();
+        }
+    }
+    pool_ref(const pool_ref&) = delete;
+    pool_ref& operator=(const pool_ref&) = delete;
+
+    work_stealing_pool& operator*() const { return *pool; }
+    work_stealing_pool* operator->() const { return pool; }
+};
+
+}
+
+#endif